@@ -1,6 +1,10 @@
 #pragma once
+#include <cstddef>
 #include <tuple>
 #include <chrono>
+#include <utility>
+#include <algorithm>
+#include <type_traits>
 
 template< typename TimeT = std::chrono::nanoseconds >
 struct Bench
@@ -27,4 +31,24 @@ struct Bench
 			std::move(ReturnValue)
 		);
 	}
+
+	// Shortest time of Rounds runs, the one least disturbed by whatever else
+	// the machine was doing
+	template< typename FunctionT >
+	static TimeT BestOf( FunctionT&& Func, std::size_t Rounds = 5 )
+	{
+		TimeT Best = TimeT::max();
+		for( std::size_t i = 0; i < Rounds; ++i )
+		{
+			Best = std::min(Best, std::get<0>(BenchResult(Func)));
+		}
+		return Best;
+	}
+
+	// Same, as time per item for a run that processes Items of them
+	template< typename FunctionT >
+	static double BestPerItem( FunctionT&& Func, double Items, std::size_t Rounds = 5 )
+	{
+		return static_cast<double>(BestOf(Func, Rounds).count()) / Items;
+	}
 };
\ No newline at end of file
@@ -0,0 +1,222 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <utility>
+
+#include "WideInt.hpp"
+
+// Arbitrary precision unsigned integer of 64-bit limbs(least significant limb
+// first). Always kept normalized, so zero is an empty limb vector.
+// This is the general "bignum" path that does not care how large F(n) gets.
+struct BigUInt
+{
+	std::vector<std::uint64_t> Limb;
+
+	BigUInt() = default;
+
+	explicit BigUInt( std::uint64_t Value )
+	{
+		if( Value )
+		{
+			Limb.push_back(Value);
+		}
+	}
+
+	BigUInt( const std::uint64_t* Limbs, std::size_t Count )
+		: Limb(Limbs, Limbs + Count)
+	{
+		Normalize();
+	}
+
+	void Normalize()
+	{
+		while( !Limb.empty() && Limb.back() == 0 )
+		{
+			Limb.pop_back();
+		}
+	}
+
+	bool operator==( const BigUInt& Other ) const
+	{
+		return Limb == Other.Limb;
+	}
+
+	bool operator!=( const BigUInt& Other ) const
+	{
+		return Limb != Other.Limb;
+	}
+
+	// Compares against a fixed-width integer
+	template< std::size_t Words >
+	bool Equals( const WideUInt<Words>& Other ) const
+	{
+		for( std::size_t i = 0; i < Words; ++i )
+		{
+			if( (i < Limb.size() ? Limb[i] : 0) != Other.Limb[i] )
+			{
+				return false;
+			}
+		}
+		return Limb.size() <= Words;
+	}
+
+	std::size_t BitWidth() const
+	{
+		if( Limb.empty() )
+		{
+			return 0;
+		}
+		#ifdef _MSC_VER
+		return Limb.size() * 64 - __lzcnt64(Limb.back());
+		#else
+		return Limb.size() * 64 - __builtin_clzll(Limb.back());
+		#endif
+	}
+
+	std::string ToString() const
+	{
+		std::vector<std::uint32_t> Halves;
+		Halves.reserve(Limb.size() * 2);
+		for( const std::uint64_t& Word : Limb )
+		{
+			Halves.push_back(static_cast<std::uint32_t>(Word));
+			Halves.push_back(static_cast<std::uint32_t>(Word >> 32));
+		}
+
+		std::string Digits;
+		while( !Halves.empty() )
+		{
+			std::uint64_t Remainder = 0;
+			for( std::size_t i = Halves.size(); i-- > 0; )
+			{
+				const std::uint64_t Cur = (Remainder << 32) | Halves[i];
+				Halves[i] = static_cast<std::uint32_t>(Cur / 1000000000U);
+				Remainder = Cur % 1000000000U;
+			}
+			while( !Halves.empty() && Halves.back() == 0 )
+			{
+				Halves.pop_back();
+			}
+			for( std::size_t i = 0; i < 9 && (!Halves.empty() || Remainder); ++i )
+			{
+				Digits.push_back(static_cast<char>('0' + Remainder % 10));
+				Remainder /= 10;
+			}
+		}
+		if( Digits.empty() )
+		{
+			Digits.push_back('0');
+		}
+		std::reverse(Digits.begin(), Digits.end());
+		return Digits;
+	}
+};
+
+inline BigUInt operator+( const BigUInt& A, const BigUInt& B )
+{
+	const BigUInt& Long  = A.Limb.size() >= B.Limb.size() ? A : B;
+	const BigUInt& Short = A.Limb.size() >= B.Limb.size() ? B : A;
+	BigUInt Result;
+	Result.Limb.resize(Long.Limb.size() + 1);
+	std::uint8_t Carry = 0;
+	std::size_t i = 0;
+	for( ; i < Short.Limb.size(); ++i )
+	{
+		Carry = WideOps::AddCarry(Carry, Long.Limb[i], Short.Limb[i], Result.Limb[i]);
+	}
+	for( ; i < Long.Limb.size(); ++i )
+	{
+		Carry = WideOps::AddCarry(Carry, Long.Limb[i], 0, Result.Limb[i]);
+	}
+	Result.Limb[i] = Carry;
+	Result.Normalize();
+	return Result;
+}
+
+// Requires A >= B
+inline BigUInt operator-( const BigUInt& A, const BigUInt& B )
+{
+	BigUInt Result;
+	Result.Limb.resize(A.Limb.size());
+	std::uint8_t Borrow = 0;
+	std::size_t i = 0;
+	for( ; i < B.Limb.size(); ++i )
+	{
+		Borrow = WideOps::SubBorrow(Borrow, A.Limb[i], B.Limb[i], Result.Limb[i]);
+	}
+	for( ; i < A.Limb.size(); ++i )
+	{
+		Borrow = WideOps::SubBorrow(Borrow, A.Limb[i], 0, Result.Limb[i]);
+	}
+	Result.Normalize();
+	return Result;
+}
+
+// Schoolbook product. Quadratic, but cheap for the lopsided products of a
+// huge operand against a small one
+inline BigUInt operator*( const BigUInt& A, const BigUInt& B )
+{
+	BigUInt Result;
+	if( A.Limb.empty() || B.Limb.empty() )
+	{
+		return Result;
+	}
+	Result.Limb.assign(A.Limb.size() + B.Limb.size(), 0);
+	for( std::size_t i = 0; i < A.Limb.size(); ++i )
+	{
+		std::uint64_t Carry = 0;
+		for( std::size_t j = 0; j < B.Limb.size(); ++j )
+		{
+			std::uint64_t High;
+			std::uint64_t Low = WideOps::MulWide(A.Limb[i], B.Limb[j], High);
+			High += WideOps::AddCarry(0, Low, Result.Limb[i + j], Low);
+			High += WideOps::AddCarry(0, Low, Carry, Low);
+			Result.Limb[i + j] = Low;
+			Carry = High;
+		}
+		Result.Limb[i + B.Limb.size()] = Carry;
+	}
+	Result.Normalize();
+	return Result;
+}
+
+// Fast doubling on arbitrary precision integers
+// Returns the pair F(n), F(n + 1)
+inline std::pair<BigUInt, BigUInt> FibBigPair( std::uint64_t n )
+{
+	BigUInt a(0); // F(0) = 0
+	BigUInt b(1); // F(1) = 1
+	if( n == 0 )
+	{
+		return std::make_pair(a, b);
+	}
+	#ifdef _MSC_VER
+	const std::uint64_t h = 64 - __lzcnt64(n);
+	#else
+	const std::uint64_t h = 64 - __builtin_clzll(n);
+	#endif
+	for( std::uint64_t mask = 1ULL << (h - 1); mask; mask >>= 1 )
+	{
+		const BigUInt c = a * ((b + b) - a); // F(2k) = F(k) * [ 2 * F(k+1) – F(k) ]
+		const BigUInt d = a * a + b * b;     // F(2k+1) = F(k)^2 + F(k+1)^2
+		if( mask & n )
+		{
+			a = d;
+			b = c + d;
+		}
+		else
+		{
+			a = c;
+			b = d;
+		}
+	}
+	return std::make_pair(std::move(a), std::move(b));
+}
+
+inline BigUInt FibBig( std::uint64_t n )
+{
+	return FibBigPair(n).first;
+}
@@ -0,0 +1,224 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <type_traits>
+
+#include <immintrin.h>
+
+// Bit-sliced fibonacci-like sequences x(n + 2) = x(n + 1) + x(n)(mod 2^Bits)
+//
+// Rather than one value per lane, every register holds one bit plane: bit j
+// of a whole batch of independent sequences, one sequence per bit position.
+// An addition becomes a ripple-carry network across the Bits planes, so the
+// cost of a step grows with Bits but is shared by all of the sequences in the
+// batch. For small Bits, far fewer instructions go into a step than with a
+// 32-bit lane per sequence, which mostly carries bits nobody looks at.
+
+namespace BitSliceImpl
+{
+#if defined(__AVX512F__)
+using Plane = __m512i;
+constexpr std::size_t Lanes = 512;
+
+inline Plane Load( const void* Source ) { return _mm512_load_si512(Source); }
+inline void  Store( void* Destination, Plane A ) { _mm512_store_si512(Destination, A); }
+
+// Sum and carry-out of a full adder are one ternary-logic instruction each
+inline Plane Xor( Plane A, Plane B ) { return _mm512_xor_si512(A, B); }
+inline Plane And( Plane A, Plane B ) { return _mm512_and_si512(A, B); }
+inline Plane Xor3( Plane A, Plane B, Plane C ) { return _mm512_ternarylogic_epi64(A, B, C, 0x96); }
+inline Plane Majority( Plane A, Plane B, Plane C ) { return _mm512_ternarylogic_epi64(A, B, C, 0xE8); }
+#else
+using Plane = __m256i;
+constexpr std::size_t Lanes = 256;
+
+inline Plane Load( const void* Source ) { return _mm256_load_si256(static_cast<const __m256i*>(Source)); }
+inline void  Store( void* Destination, Plane A ) { _mm256_store_si256(static_cast<__m256i*>(Destination), A); }
+
+inline Plane Xor( Plane A, Plane B ) { return _mm256_xor_si256(A, B); }
+inline Plane And( Plane A, Plane B ) { return _mm256_and_si256(A, B); }
+inline Plane Xor3( Plane A, Plane B, Plane C ) { return Xor(Xor(A, B), C); }
+inline Plane Majority( Plane A, Plane B, Plane C )
+{
+	return _mm256_or_si256(And(A, B), And(C, Xor(A, B)));
+}
+#endif
+
+// Planes J and up of Sum += Addend, with the carry into plane J
+// Unrolled at compile time, so that every plane index is a constant and the
+// planes can stay in registers
+
+// No carry out of the highest plane
+template< std::size_t Bits, std::size_t J >
+inline typename std::enable_if<(J + 1 == Bits)>::type Ripple(
+	Plane* Sum, const Plane* Addend, Plane Carry
+)
+{
+	Sum[J] = Xor3(Sum[J], Addend[J], Carry);
+}
+
+template< std::size_t Bits, std::size_t J >
+inline typename std::enable_if<(J + 1 < Bits)>::type Ripple(
+	Plane* Sum, const Plane* Addend, Plane Carry
+)
+{
+	const Plane Bit = Xor3(Sum[J], Addend[J], Carry);
+	Carry = Majority(Sum[J], Addend[J], Carry);
+	Sum[J] = Bit;
+	Ripple<Bits, J + 1>(Sum, Addend, Carry);
+}
+
+// Sum += Addend, across Bits planes
+template< std::size_t Bits >
+inline typename std::enable_if<(Bits == 1)>::type Add( Plane* Sum, const Plane* Addend )
+{
+	Sum[0] = Xor(Sum[0], Addend[0]);
+}
+
+template< std::size_t Bits >
+inline typename std::enable_if<(Bits > 1)>::type Add( Plane* Sum, const Plane* Addend )
+{
+	// No carry into the lowest plane
+	const Plane Carry = And(Sum[0], Addend[0]);
+	Sum[0] = Xor(Sum[0], Addend[0]);
+	Ripple<Bits, 1>(Sum, Addend, Carry);
+}
+
+// Bits planes into Lanes values, and back
+// Values only keep their low Bits bits
+template< std::size_t Bits >
+inline void Transpose( const std::uint32_t* Values, Plane* Planes )
+{
+	alignas(64) std::uint16_t Masks[Bits][Lanes / 16];
+	for( std::size_t i = 0; i < Lanes / 16; ++i )
+	{
+		#if defined(__AVX512F__)
+		const __m512i Value = _mm512_loadu_si512(Values + i * 16);
+		for( std::size_t j = 0; j < Bits; ++j )
+		{
+			Masks[j][i] = _mm512_test_epi32_mask(Value, _mm512_set1_epi32(static_cast<int>(1u << j)));
+		}
+		#else
+		const __m256i Low  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Values + i * 16));
+		const __m256i High = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(Values + i * 16 + 8));
+		for( std::size_t j = 0; j < Bits; ++j )
+		{
+			// Bit j into the sign bit of each lane
+			const __m128i Shift = _mm_cvtsi32_si128(static_cast<int>(31 - j));
+			Masks[j][i] = static_cast<std::uint16_t>(
+				_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_sll_epi32(Low, Shift)))
+				| _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_sll_epi32(High, Shift))) << 8
+			);
+		}
+		#endif
+	}
+	for( std::size_t j = 0; j < Bits; ++j )
+	{
+		Planes[j] = Load(Masks[j]);
+	}
+}
+
+template< std::size_t Bits >
+inline void Transpose( const Plane* Planes, std::uint32_t* Values )
+{
+	alignas(64) std::uint16_t Masks[Bits][Lanes / 16];
+	for( std::size_t j = 0; j < Bits; ++j )
+	{
+		Store(Masks[j], Planes[j]);
+	}
+	for( std::size_t i = 0; i < Lanes / 16; ++i )
+	{
+		#if defined(__AVX512F__)
+		__m512i Value = _mm512_setzero_si512();
+		for( std::size_t j = 0; j < Bits; ++j )
+		{
+			Value = _mm512_mask_or_epi32(Value, Masks[j][i], Value, _mm512_set1_epi32(static_cast<int>(1u << j)));
+		}
+		_mm512_storeu_si512(Values + i * 16, Value);
+		#else
+		// One bit of the mask per lane
+		const __m256i Select = _mm256_set_epi32(128, 64, 32, 16, 8, 4, 2, 1);
+		__m256i Low  = _mm256_setzero_si256();
+		__m256i High = _mm256_setzero_si256();
+		for( std::size_t j = 0; j < Bits; ++j )
+		{
+			const __m256i Bit = _mm256_set1_epi32(static_cast<int>(1u << j));
+			const __m256i LowMask  = _mm256_set1_epi32(Masks[j][i] & 0xFF);
+			const __m256i HighMask = _mm256_set1_epi32(Masks[j][i] >> 8);
+			Low = _mm256_or_si256(
+				Low, _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(LowMask, Select), Select), Bit)
+			);
+			High = _mm256_or_si256(
+				High, _mm256_and_si256(_mm256_cmpeq_epi32(_mm256_and_si256(HighMask, Select), Select), Bit)
+			);
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Values + i * 16), Low);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Values + i * 16 + 8), High);
+		#endif
+	}
+}
+}
+
+// BitSlicedFib::Lanes sequences of Bits-bit values, stepped in lockstep
+template< std::size_t Bits >
+class BitSlicedFib
+{
+public:
+	static_assert(Bits >= 1 && Bits <= 32, "Values are handed in and out as 32-bit integers");
+
+	using Plane = BitSliceImpl::Plane;
+	static constexpr std::size_t Lanes = BitSliceImpl::Lanes;
+
+	// Seeds every sequence with its own x(0), x(1), Lanes values each
+	BitSlicedFib( const std::uint32_t* Seed0, const std::uint32_t* Seed1 )
+	{
+		BitSliceImpl::Transpose<Bits>(Seed0, Terms[0]);
+		BitSliceImpl::Transpose<Bits>(Seed1, Terms[1]);
+	}
+
+	// Advances every sequence by Count terms
+	void Step( std::size_t Count )
+	{
+		// Local copies, so that the planes can live in registers
+		const std::size_t First = Current;
+		Plane Term[Bits], Next[Bits];
+		for( std::size_t j = 0; j < Bits; ++j )
+		{
+			Term[j] = Terms[First][j];
+			Next[j] = Terms[First ^ 1][j];
+		}
+		// x(n) and x(n + 1) trade places instead of moving planes around
+		for( ; Count >= 2; Count -= 2 )
+		{
+			BitSliceImpl::Add<Bits>(Term, Next);
+			BitSliceImpl::Add<Bits>(Next, Term);
+		}
+		if( Count )
+		{
+			BitSliceImpl::Add<Bits>(Term, Next);
+			Current ^= 1;
+		}
+		for( std::size_t j = 0; j < Bits; ++j )
+		{
+			Terms[First][j] = Term[j];
+			Terms[First ^ 1][j] = Next[j];
+		}
+	}
+
+	// x(n) of every sequence
+	void Get( std::uint32_t* Values ) const
+	{
+		BitSliceImpl::Transpose<Bits>(Terms[Current], Values);
+	}
+
+	// Bit j of x(n) for all sequences, for consumers that can work on the
+	// planes directly
+	const Plane& GetPlane( std::size_t j ) const
+	{
+		return Terms[Current][j];
+	}
+
+private:
+	Plane Terms[2][Bits];
+	std::size_t Current = 0;
+};
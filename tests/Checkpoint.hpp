@@ -0,0 +1,387 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "BigUInt.hpp"
+
+// On-disk store of exact F(k), F(k + 1) checkpoints
+//
+// Built once offline by ckptbuild, then memory-mapped read-only so that
+// opening it costs no parsing and its pages are shared between processes.
+// A query for F(n) starts from the closest checkpoint at or below n and
+// only has to cover the remaining distance m = n - k:
+//   F(k + m)     = F(k + 1) * F(m)     + F(k) * F(m - 1)
+//   F(k + m + 1) = F(k + 1) * F(m + 1) + F(k) * F(m)
+// which are lopsided products of a huge term against a small one.
+//
+// Layout, native-endian and 8-byte aligned throughout so it is used in place:
+//   CheckpointHeader
+//   CheckpointEntry[Count], sorted by Index
+//   Limbs of F(k) and then F(k + 1) of every entry, least significant first
+
+struct CheckpointHeader
+{
+	char Magic[8];
+	std::uint32_t Version;
+	// Guards against reading a file written with a different layout
+	std::uint32_t EntrySize;
+	std::uint64_t Count;
+	std::uint64_t LimbCount;
+};
+
+struct CheckpointEntry
+{
+	std::uint64_t Index;
+	// In limbs, from the first limb after the entries
+	std::uint64_t Offset;
+	std::uint64_t Limbs0;
+	std::uint64_t Limbs1;
+};
+
+namespace CheckpointImpl
+{
+constexpr char Magic[8] = { 'q', 'F', 'i', 'b', 'C', 'k', 'p', 't' };
+constexpr std::uint32_t Version = 1;
+
+[[noreturn]] inline void ThrowErrno( const std::string& What )
+{
+	throw std::system_error(errno, std::generic_category(), What);
+}
+
+// F(p + m), F(p + m + 1) from F(p), F(p + 1) and F(m), F(m + 1)
+inline std::pair<BigUInt, BigUInt> Jump(
+	const std::pair<BigUInt, BigUInt>& P, const std::pair<BigUInt, BigUInt>& M
+)
+{
+	// F(m - 1) = F(m + 1) - F(m), which also holds for F(-1) = 1
+	const BigUInt Previous = M.second - M.first;
+	return std::make_pair(
+		P.second * M.first + P.first * Previous,
+		P.second * M.second + P.first * M.first
+	);
+}
+
+// Makes a rename of Path durable
+inline void SyncDirectory( const std::string& Path )
+{
+	const std::size_t Slash = Path.rfind('/');
+	const std::string Directory =
+		Slash == std::string::npos ? "." : Slash == 0 ? "/" : Path.substr(0, Slash);
+	const int Handle = ::open(Directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if( Handle < 0 )
+	{
+		ThrowErrno("Opening " + Directory);
+	}
+	const int Synced = ::fsync(Handle);
+	const int Error = errno;
+	::close(Handle);
+	if( Synced != 0 )
+	{
+		throw std::system_error(Error, std::generic_category(), "Syncing " + Directory);
+	}
+}
+
+inline void WriteAll( std::FILE* File, const void* Data, std::size_t Size, const std::string& Path )
+{
+	if( Size && std::fwrite(Data, 1, Size, File) != Size )
+	{
+		ThrowErrno("Writing " + Path);
+	}
+}
+}
+
+// Checkpoint indices up to MaxIndex, Stride apart
+// A Growth above 1 widens the gaps geometrically instead, every checkpoint
+// then sits at least Growth times further out than the one before it
+inline std::vector<std::uint64_t> CheckpointIndices(
+	std::uint64_t MaxIndex, std::uint64_t Stride, double Growth = 1.0
+)
+{
+	std::vector<std::uint64_t> Indices;
+	if( !Stride )
+	{
+		return Indices;
+	}
+	for( std::uint64_t k = Stride; k <= MaxIndex; )
+	{
+		Indices.push_back(k);
+		// Checked in double first, past MaxIndex the cast may not even fit
+		const double Grown = k * Growth;
+		if( !(Grown < static_cast<double>(MaxIndex) + 1.0) )
+		{
+			break;
+		}
+		const std::uint64_t Next = std::max(k + Stride, static_cast<std::uint64_t>(Grown));
+		if( Next <= k )
+		{
+			break;
+		}
+		k = Next;
+	}
+	return Indices;
+}
+
+// Writes a checkpoint at every one of Indices, which must be strictly
+// increasing, as CheckpointStore will not open a file that repeats one
+// The file is written to a uniquely named temporary next to Path, synced,
+// and renamed over it once complete. Processes that still map an older store
+// are left undisturbed, and a crash leaves either the old file or the new one
+// but never a truncated one
+inline void WriteCheckpoints( const std::string& Path, const std::vector<std::uint64_t>& Indices )
+{
+	if( std::adjacent_find(Indices.begin(), Indices.end(), std::greater_equal<std::uint64_t>()) != Indices.end() )
+	{
+		throw std::invalid_argument("Checkpoint indices must be strictly increasing");
+	}
+	std::string Temporary = Path + ".XXXXXX";
+	const int Descriptor = ::mkstemp(&Temporary[0]);
+	if( Descriptor < 0 )
+	{
+		CheckpointImpl::ThrowErrno("Creating " + Temporary);
+	}
+	// mkstemp leaves it private, but the store is meant to be shared
+	std::FILE* File = ::fchmod(Descriptor, 0644) == 0 ? ::fdopen(Descriptor, "wb") : nullptr;
+	if( !File )
+	{
+		const int Error = errno;
+		::close(Descriptor);
+		std::remove(Temporary.c_str());
+		throw std::system_error(Error, std::generic_category(), "Creating " + Temporary);
+	}
+	try
+	{
+		CheckpointHeader Header;
+		std::memcpy(Header.Magic, CheckpointImpl::Magic, sizeof(Header.Magic));
+		Header.Version = CheckpointImpl::Version;
+		Header.EntrySize = sizeof(CheckpointEntry);
+		Header.Count = Indices.size();
+		Header.LimbCount = 0;
+
+		// Entries are only known once their terms are, so leave room for them
+		std::vector<CheckpointEntry> Entries(Indices.size());
+		CheckpointImpl::WriteAll(File, &Header, sizeof(Header), Temporary);
+		CheckpointImpl::WriteAll(
+			File, Entries.data(), Entries.size() * sizeof(CheckpointEntry), Temporary
+		);
+
+		// Each checkpoint jumps from the one before it, and regular spacing
+		// reuses the same jump. Only a checkpoint at F(0) needs no jump at all
+		std::pair<BigUInt, BigUInt> Current(BigUInt(0), BigUInt(1));
+		std::uint64_t CurrentIndex = 0;
+		std::uint64_t LastGap = 0;
+		std::pair<BigUInt, BigUInt> GapPair = FibBigPair(0);
+		for( std::size_t i = 0; i < Indices.size(); ++i )
+		{
+			const std::uint64_t Gap = Indices[i] - CurrentIndex;
+			if( Gap )
+			{
+				if( Gap != LastGap )
+				{
+					GapPair = FibBigPair(Gap);
+					LastGap = Gap;
+				}
+				Current = CheckpointImpl::Jump(Current, GapPair);
+				CurrentIndex = Indices[i];
+			}
+			Entries[i].Index  = Indices[i];
+			Entries[i].Offset = Header.LimbCount;
+			Entries[i].Limbs0 = Current.first.Limb.size();
+			Entries[i].Limbs1 = Current.second.Limb.size();
+			CheckpointImpl::WriteAll(
+				File, Current.first.Limb.data(), Entries[i].Limbs0 * sizeof(std::uint64_t), Temporary
+			);
+			CheckpointImpl::WriteAll(
+				File, Current.second.Limb.data(), Entries[i].Limbs1 * sizeof(std::uint64_t), Temporary
+			);
+			Header.LimbCount += Entries[i].Limbs0 + Entries[i].Limbs1;
+		}
+
+		if( std::fseek(File, 0, SEEK_SET) != 0 )
+		{
+			CheckpointImpl::ThrowErrno("Seeking " + Temporary);
+		}
+		CheckpointImpl::WriteAll(File, &Header, sizeof(Header), Temporary);
+		CheckpointImpl::WriteAll(
+			File, Entries.data(), Entries.size() * sizeof(CheckpointEntry), Temporary
+		);
+		if( std::fflush(File) != 0 || ::fsync(::fileno(File)) != 0 )
+		{
+			CheckpointImpl::ThrowErrno("Syncing " + Temporary);
+		}
+		if( std::fclose(File) != 0 )
+		{
+			File = nullptr;
+			CheckpointImpl::ThrowErrno("Closing " + Temporary);
+		}
+		File = nullptr;
+		if( std::rename(Temporary.c_str(), Path.c_str()) != 0 )
+		{
+			CheckpointImpl::ThrowErrno("Renaming " + Temporary);
+		}
+		CheckpointImpl::SyncDirectory(Path);
+	}
+	catch( ... )
+	{
+		if( File )
+		{
+			std::fclose(File);
+		}
+		std::remove(Temporary.c_str());
+		throw;
+	}
+}
+
+// Read-only view of a checkpoint file
+class CheckpointStore
+{
+public:
+	explicit CheckpointStore( const std::string& Path )
+	{
+		const int File = ::open(Path.c_str(), O_RDONLY | O_CLOEXEC);
+		if( File < 0 )
+		{
+			CheckpointImpl::ThrowErrno("Opening " + Path);
+		}
+		struct stat Status;
+		if( ::fstat(File, &Status) != 0 )
+		{
+			::close(File);
+			CheckpointImpl::ThrowErrno("Reading the size of " + Path);
+		}
+		MappingSize = static_cast<std::size_t>(Status.st_size);
+		if( MappingSize < sizeof(CheckpointHeader) )
+		{
+			::close(File);
+			throw std::runtime_error(Path + " is too small to be a checkpoint file");
+		}
+		Mapping = ::mmap(nullptr, MappingSize, PROT_READ, MAP_SHARED, File, 0);
+		::close(File);
+		if( Mapping == MAP_FAILED )
+		{
+			CheckpointImpl::ThrowErrno("Mapping " + Path);
+		}
+
+		Header = static_cast<const CheckpointHeader*>(Mapping);
+		Entries = reinterpret_cast<const CheckpointEntry*>(Header + 1);
+		Limbs = reinterpret_cast<const std::uint64_t*>(Entries + Header->Count);
+		if( !Valid() )
+		{
+			::munmap(Mapping, MappingSize);
+			throw std::runtime_error(Path + " is not a valid checkpoint file");
+		}
+	}
+
+	~CheckpointStore()
+	{
+		::munmap(Mapping, MappingSize);
+	}
+
+	CheckpointStore( const CheckpointStore& ) = delete;
+	CheckpointStore& operator=( const CheckpointStore& ) = delete;
+
+	std::size_t Size() const
+	{
+		return static_cast<std::size_t>(Header->Count);
+	}
+
+	const CheckpointEntry& operator[]( std::size_t i ) const
+	{
+		return Entries[i];
+	}
+
+	// Closest checkpoint at or below n, nullptr if there is none
+	const CheckpointEntry* Nearest( std::uint64_t n ) const
+	{
+		const CheckpointEntry* End = Entries + Header->Count;
+		const CheckpointEntry* Above = std::upper_bound(
+			Entries, End, n,
+			[]( std::uint64_t Index, const CheckpointEntry& Entry )
+			{
+				return Index < Entry.Index;
+			}
+		);
+		return Above == Entries ? nullptr : Above - 1;
+	}
+
+	// Returns the pair F(n), F(n + 1)
+	std::pair<BigUInt, BigUInt> FibPair( std::uint64_t n ) const
+	{
+		const CheckpointEntry* Entry = Nearest(n);
+		if( !Entry )
+		{
+			return FibBigPair(n);
+		}
+		std::pair<BigUInt, BigUInt> Checkpoint(
+			BigUInt(Limbs + Entry->Offset, Entry->Limbs0),
+			BigUInt(Limbs + Entry->Offset + Entry->Limbs0, Entry->Limbs1)
+		);
+		if( n == Entry->Index )
+		{
+			return Checkpoint;
+		}
+		return CheckpointImpl::Jump(Checkpoint, FibBigPair(n - Entry->Index));
+	}
+
+	BigUInt Fib( std::uint64_t n ) const
+	{
+		return FibPair(n).first;
+	}
+
+private:
+	// Only the bounds are checked, not the terms themselves
+	bool Valid() const
+	{
+		if(
+			std::memcmp(Header->Magic, CheckpointImpl::Magic, sizeof(Header->Magic)) != 0
+			|| Header->Version != CheckpointImpl::Version
+			|| Header->EntrySize != sizeof(CheckpointEntry)
+		)
+		{
+			return false;
+		}
+		const std::size_t Available = MappingSize - sizeof(CheckpointHeader);
+		if(
+			Header->Count > Available / sizeof(CheckpointEntry)
+			|| Header->LimbCount != (Available - Header->Count * sizeof(CheckpointEntry)) / sizeof(std::uint64_t)
+		)
+		{
+			return false;
+		}
+		for( std::uint64_t i = 0; i < Header->Count; ++i )
+		{
+			const CheckpointEntry& Entry = Entries[i];
+			if(
+				(i && Entry.Index <= Entries[i - 1].Index)
+				|| Entry.Offset > Header->LimbCount
+				|| Entry.Limbs0 > Header->LimbCount - Entry.Offset
+				|| Entry.Limbs1 > Header->LimbCount - Entry.Offset - Entry.Limbs0
+			)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void* Mapping = nullptr;
+	std::size_t MappingSize = 0;
+	const CheckpointHeader* Header = nullptr;
+	const CheckpointEntry* Entries = nullptr;
+	const std::uint64_t* Limbs = nullptr;
+};
@@ -0,0 +1,216 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <utility>
+#include <type_traits>
+
+#include <immintrin.h>
+
+// Matrices of constant coefficients, known at compile time
+//
+// Matrix-vector products get lowered into shifts and adds while compiling:
+// every coefficient is broken down into its set bits, zero coefficients
+// produce no code at all, and a power-of-two coefficient becomes one shift.
+// This is the same reduction that went into FibNext4 by hand.
+
+// Element types that can be shifted and added
+template< typename T >
+struct ShiftAdd
+{
+	static T Zero()
+	{
+		return T(0);
+	}
+	template< std::uint32_t Shift >
+	static T Shl( const T& Value )
+	{
+		return static_cast<T>(Value << Shift);
+	}
+	static T Add( const T& A, const T& B )
+	{
+		return static_cast<T>(A + B);
+	}
+};
+
+// Vector registers as elements, each lane being an independent value
+// Wrapped so that they can be template arguments
+struct U32x4
+{
+	__m128i Lanes;
+};
+
+struct U64x4
+{
+	__m256i Lanes;
+};
+
+template<>
+struct ShiftAdd<U32x4>
+{
+	static U32x4 Zero()
+	{
+		return { _mm_setzero_si128() };
+	}
+	template< std::uint32_t Shift >
+	static U32x4 Shl( const U32x4& Value )
+	{
+		return { Shift ? _mm_slli_epi32(Value.Lanes, Shift) : Value.Lanes };
+	}
+	static U32x4 Add( const U32x4& A, const U32x4& B )
+	{
+		return { _mm_add_epi32(A.Lanes, B.Lanes) };
+	}
+};
+
+template<>
+struct ShiftAdd<U64x4>
+{
+	static U64x4 Zero()
+	{
+		return { _mm256_setzero_si256() };
+	}
+	template< std::uint32_t Shift >
+	static U64x4 Shl( const U64x4& Value )
+	{
+		return { Shift ? _mm256_slli_epi64(Value.Lanes, Shift) : Value.Lanes };
+	}
+	static U64x4 Add( const U64x4& A, const U64x4& B )
+	{
+		return { _mm256_add_epi64(A.Lanes, B.Lanes) };
+	}
+};
+
+namespace ConstMatrixImpl
+{
+// I-th value of a parameter pack
+template< std::size_t I, std::uint32_t Head, std::uint32_t... Tail >
+struct PackElement : PackElement<I - 1, Tail...> {};
+
+template< std::uint32_t Head, std::uint32_t... Tail >
+struct PackElement<0, Head, Tail...> : std::integral_constant<std::uint32_t, Head> {};
+
+constexpr std::uint32_t Log2( std::uint32_t Value )
+{
+	return Value > 1 ? 1 + Log2(Value >> 1) : 0;
+}
+
+template< std::uint32_t Value >
+using Coefficient = std::integral_constant<std::uint32_t, Value>;
+
+// A term that is known to be zero at compile time
+struct ZeroTerm {};
+
+template< typename T >
+T Accumulate( const T& A, const T& B )
+{
+	return ShiftAdd<T>::Add(A, B);
+}
+
+template< typename T >
+T Accumulate( const T& A, ZeroTerm )
+{
+	return A;
+}
+
+template< typename T >
+T Accumulate( ZeroTerm, const T& B )
+{
+	return B;
+}
+
+inline ZeroTerm Accumulate( ZeroTerm, ZeroTerm )
+{
+	return {};
+}
+
+template< typename T >
+ZeroTerm Scale( const T&, Coefficient<0> )
+{
+	return {};
+}
+
+// Peels off the lowest set bit as a shift, then the rest of the bits
+template< typename T, std::uint32_t Value >
+T Scale( const T& Term, Coefficient<Value> )
+{
+	return Accumulate(
+		ShiftAdd<T>::template Shl<Log2(Value & (~Value + 1))>(Term),
+		Scale(Term, Coefficient<Value & (Value - 1)>())
+	);
+}
+
+template< typename T >
+T Sum( const T& Term )
+{
+	return Term;
+}
+
+template< typename A, typename B, typename... RestT >
+auto Sum( const A& First, const B& Second, const RestT&... Rest )
+{
+	return Sum(Accumulate(First, Second), Rest...);
+}
+
+template< typename T >
+T Materialize( const T& Term )
+{
+	return Term;
+}
+
+template< typename T >
+T Materialize( ZeroTerm )
+{
+	return ShiftAdd<T>::Zero();
+}
+}
+
+template< std::size_t Rows, std::size_t Cols, std::uint32_t... Coefficients >
+struct ConstMatrix
+{
+	static_assert(
+		sizeof...(Coefficients) == Rows * Cols,
+		"Coefficient count must match the matrix dimensions"
+	);
+
+	// Coefficients are in row-major order
+	template< std::size_t Row, std::size_t Col >
+	using At = ConstMatrixImpl::PackElement<Row * Cols + Col, Coefficients...>;
+
+	template< typename T >
+	static std::array<T, Rows> Multiply( const std::array<T, Cols>& Vector )
+	{
+		return MultiplyRows(Vector, std::make_index_sequence<Rows>());
+	}
+
+private:
+	template< typename T, std::size_t... Row >
+	static std::array<T, Rows> MultiplyRows(
+		const std::array<T, Cols>& Vector, std::index_sequence<Row...>
+	)
+	{
+		return {{ RowProduct<Row>(Vector, std::make_index_sequence<Cols>())... }};
+	}
+
+	template< std::size_t Row, typename T, std::size_t... Col >
+	static T RowProduct( const std::array<T, Cols>& Vector, std::index_sequence<Col...> )
+	{
+		return ConstMatrixImpl::Materialize<T>(
+			ConstMatrixImpl::Sum(
+				ConstMatrixImpl::Scale(
+					Vector[Col], ConstMatrixImpl::Coefficient<At<Row, Col>::value>()
+				)...
+			)
+		);
+	}
+};
+
+// The four-term stride matrix from the readme
+// { F(n + 7), F(n + 6), F(n + 5), F(n + 4) } = Multiply({ F(n + 3), ..., F(n) })
+using FibNextState = ConstMatrix<
+	4, 4,
+	4, 4, 1, 0,
+	1, 4, 2, 0,
+	2, 1, 0, 0,
+	1, 1, 0, 0
+>;
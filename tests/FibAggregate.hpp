@@ -0,0 +1,307 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <utility>
+
+#include <immintrin.h>
+
+#include "FibKernels.hpp"
+#include "FibBatch.hpp"
+#include "FibVisit.hpp"
+
+// Aggregates of F(i) over an index range [First, Last], mod Modulus
+// A Modulus of 0 means 2^64
+//
+// The recurrence state is extended with an accumulator row, so that one
+// step of the state both advances the terms and adds the current one into
+// the running total:
+//   Sum:      (F(i), F(i + 1), S) -> (F(i + 1), F(i) + F(i + 1), S + w * F(i))
+//   Squares:  (F(i)^2, F(i)F(i + 1), F(i + 1)^2, S)
+//          -> (F(i + 1)^2, F(i + 1)F(i + 2), F(i + 2)^2, S + F(i)^2)
+// These steps are linear, so a whole range is one matrix power applied to
+// the state at First, O(log n) regardless of its length. Short ranges are
+// cheaper to just generate with FibVisit and add up.
+
+// Ranges up to this many terms are generated rather than raised to a power,
+// mod 2^64 only. Around where the two meet on an AVX-512 core
+constexpr std::uint64_t FibAggregateShortRange = 256;
+
+namespace FibAggregateImpl
+{
+// Arithmetic mod Modulus, 0 meaning 2^64
+struct Ring
+{
+	std::uint64_t Modulus;
+
+	std::uint64_t Reduce( std::uint64_t A ) const
+	{
+		return Modulus ? A % Modulus : A;
+	}
+
+	std::uint64_t Add( std::uint64_t A, std::uint64_t B ) const
+	{
+		if( !Modulus )
+		{
+			return A + B;
+		}
+		return A >= Modulus - B ? A - (Modulus - B) : A + B;
+	}
+
+	std::uint64_t Mul( std::uint64_t A, std::uint64_t B ) const
+	{
+		return Modulus ? MulMod(A, B, Modulus) : A * B;
+	}
+};
+
+template< std::size_t N >
+using Vector = std::array<std::uint64_t, N>;
+
+// Row-major
+template< std::size_t N >
+using Matrix = std::array<Vector<N>, N>;
+
+template< std::size_t N >
+Vector<N> Apply( const Matrix<N>& M, const Vector<N>& V, const Ring& R )
+{
+	Vector<N> Result;
+	for( std::size_t i = 0; i < N; ++i )
+	{
+		std::uint64_t Sum = 0;
+		for( std::size_t k = 0; k < N; ++k )
+		{
+			Sum = R.Add(Sum, R.Mul(M[i][k], V[k]));
+		}
+		Result[i] = Sum;
+	}
+	return Result;
+}
+
+template< std::size_t N >
+Matrix<N> Multiply( const Matrix<N>& A, const Matrix<N>& B, const Ring& R )
+{
+	Matrix<N> Result;
+	// Plain wrapping arithmetic mod 2^64, which the compiler is free to
+	// unroll and reorder
+	if( !R.Modulus )
+	{
+		for( std::size_t i = 0; i < N; ++i )
+		{
+			for( std::size_t j = 0; j < N; ++j )
+			{
+				Result[i][j] = A[i][0] * B[0][j];
+				for( std::size_t k = 1; k < N; ++k )
+				{
+					Result[i][j] += A[i][k] * B[k][j];
+				}
+			}
+		}
+		return Result;
+	}
+	for( std::size_t i = 0; i < N; ++i )
+	{
+		for( std::size_t j = 0; j < N; ++j )
+		{
+			std::uint64_t Sum = 0;
+			for( std::size_t k = 0; k < N; ++k )
+			{
+				Sum = R.Add(Sum, R.Mul(A[i][k], B[k][j]));
+			}
+			Result[i][j] = Sum;
+		}
+	}
+	return Result;
+}
+
+// M^Count * V
+// Powers of the same matrix commute, so the squares can be applied to the
+// vector lowest bit first and no matrix-matrix product is ever wasted on
+// the result
+template< std::size_t N >
+Vector<N> Advance( Matrix<N> M, std::uint64_t Count, Vector<N> V, const Ring& R )
+{
+	while( Count )
+	{
+		if( Count & 1 )
+		{
+			V = Apply(M, V, R);
+		}
+		Count >>= 1;
+		if( Count )
+		{
+			M = Multiply(M, M, R);
+		}
+	}
+	return V;
+}
+
+// The matrix of a linear step, one column per unit vector
+template< std::size_t N, typename StepT >
+Matrix<N> StepMatrix( StepT&& Step )
+{
+	Matrix<N> M;
+	for( std::size_t k = 0; k < N; ++k )
+	{
+		Vector<N> Unit = {};
+		Unit[k] = 1;
+		const Vector<N> Column = Step(Unit);
+		for( std::size_t i = 0; i < N; ++i )
+		{
+			M[i][k] = Column[i];
+		}
+	}
+	return M;
+}
+
+inline Vector<3> SumStep( const Vector<3>& V, std::uint64_t Weight, const Ring& R )
+{
+	return {{ V[1], R.Add(V[0], V[1]), R.Add(V[2], R.Mul(Weight, V[0])) }};
+}
+
+inline Vector<4> SquareStep( const Vector<4>& V, const Ring& R )
+{
+	return {{
+		V[2],
+		R.Add(V[1], V[2]),
+		R.Add(R.Add(V[0], V[2]), R.Add(V[1], V[1])),
+		R.Add(V[3], V[0])
+	}};
+}
+}
+
+// Sum of F(i) for i in [First, Last], 0 if Last < First
+inline std::uint64_t FibRangeSum( std::uint64_t First, std::uint64_t Last, std::uint64_t Modulus = 0 )
+{
+	using namespace FibAggregateImpl;
+	if( Last < First )
+	{
+		return 0;
+	}
+	if( !Modulus && Last - First < FibAggregateShortRange )
+	{
+		__m256i Sum = _mm256_setzero_si256();
+		FibVisit(
+			First, Last - First + 1,
+			[&]( __m256i Terms, std::uint64_t, std::size_t Count ) -> bool
+			{
+				Sum = _mm256_add_epi64(Sum, FibVisitMasked(Terms, Count));
+				return true;
+			}
+		);
+		return FibVisitSum(Sum);
+	}
+	const Ring R{ Modulus };
+	const auto Pair = FibModPair(First, Modulus);
+	// Last - First steps sum all but F(Last), which is then the state itself
+	// and the range may span every index without overflowing the count
+	const Vector<3> State = Advance(
+		StepMatrix<3>([&]( const Vector<3>& V ) { return SumStep(V, 1, R); }),
+		Last - First, Vector<3>{{ Pair.first, Pair.second, 0 }}, R
+	);
+	return R.Add(State[2], State[0]);
+}
+
+// Sum of F(i)^2 for i in [First, Last], 0 if Last < First
+inline std::uint64_t FibRangeSquareSum( std::uint64_t First, std::uint64_t Last, std::uint64_t Modulus = 0 )
+{
+	using namespace FibAggregateImpl;
+	if( Last < First )
+	{
+		return 0;
+	}
+	if( !Modulus && Last - First < FibAggregateShortRange )
+	{
+		__m256i Sum = _mm256_setzero_si256();
+		FibVisit(
+			First, Last - First + 1,
+			[&]( __m256i Terms, std::uint64_t, std::size_t Count ) -> bool
+			{
+				Terms = FibVisitMasked(Terms, Count);
+				Sum = _mm256_add_epi64(Sum, MulLo64x4(Terms, Terms));
+				return true;
+			}
+		);
+		return FibVisitSum(Sum);
+	}
+	const Ring R{ Modulus };
+	const auto Pair = FibModPair(First, Modulus);
+	const Vector<4> State = Advance(
+		StepMatrix<4>([&]( const Vector<4>& V ) { return SquareStep(V, R); }),
+		Last - First,
+		Vector<4>{{ R.Mul(Pair.first, Pair.first), R.Mul(Pair.first, Pair.second), R.Mul(Pair.second, Pair.second), 0 }},
+		R
+	);
+	return R.Add(State[3], State[0]);
+}
+
+// Sum of Weights[i % Period] * F(i) for i in [First, Last], 0 if Last < First
+// The weights line up with absolute indices, so Weights[0] goes with every
+// multiple of Period
+inline std::uint64_t FibRangeWeightedSum(
+	std::uint64_t First, std::uint64_t Last,
+	const std::uint64_t* Weights, std::size_t Period, std::uint64_t Modulus = 0
+)
+{
+	using namespace FibAggregateImpl;
+	if( Last < First || !Period )
+	{
+		return 0;
+	}
+	const Ring R{ Modulus };
+	std::size_t Residue = First % Period;
+
+	if( !Modulus && Last - First < FibAggregateShortRange )
+	{
+		// Weights repeated past the end of the period, so that any four
+		// consecutive residues are one load
+		std::vector<std::uint64_t> Repeated(Period + 3);
+		for( std::size_t k = 0; k < Repeated.size(); ++k )
+		{
+			Repeated[k] = Weights[k % Period];
+		}
+		__m256i Sum = _mm256_setzero_si256();
+		FibVisit(
+			First, Last - First + 1,
+			[&]( __m256i Terms, std::uint64_t, std::size_t Count ) -> bool
+			{
+				const __m256i Weight = _mm256_loadu_si256(
+					reinterpret_cast<const __m256i*>(Repeated.data() + Residue)
+				);
+				Sum = _mm256_add_epi64(Sum, MulLo64x4(FibVisitMasked(Terms, Count), Weight));
+				Residue = (Residue + 4) % Period;
+				return true;
+			}
+		);
+		return FibVisitSum(Sum);
+	}
+
+	std::vector<std::uint64_t> Reduced(Weights, Weights + Period);
+	for( std::uint64_t& Weight : Reduced )
+	{
+		Weight = R.Reduce(Weight);
+	}
+	const auto Pair = FibModPair(First, Modulus);
+	Vector<3> State{{ Pair.first, Pair.second, 0 }};
+
+	// One whole period starting at the residue of First, raised to the number
+	// of whole periods, then the steps that are left over one at a time
+	const std::uint64_t Steps = Last - First;
+	const Matrix<3> Cycle = StepMatrix<3>(
+		[&]( Vector<3> V )
+		{
+			for( std::size_t k = 0; k < Period; ++k )
+			{
+				V = SumStep(V, Reduced[(Residue + k) % Period], R);
+			}
+			return V;
+		}
+	);
+	State = Advance(Cycle, Steps / Period, State, R);
+	for( std::uint64_t k = 0; k < Steps % Period; ++k )
+	{
+		State = SumStep(State, Reduced[Residue], R);
+		Residue = Residue + 1 == Period ? 0 : Residue + 1;
+	}
+	return R.Add(State[2], R.Mul(Reduced[Residue], State[0]));
+}
@@ -0,0 +1,244 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#if !defined(__AVX512F__) && !(defined(__AVX2__) && defined(__FMA__))
+#error "FibApprox.hpp needs AVX-512F, or AVX2 with FMA"
+#endif
+
+#include "FibSimd.hpp"
+
+// Approximate F(n) in floating point, for when only the magnitude matters
+//
+// Binet's formula F(n) = (phi^n - psi^n) / sqrt(5) is evaluated in the log
+// domain, one index per lane:
+//   log_b F(n) = n * log_b(phi) - log_b(sqrt(5)) + log_b(1 - (-1)^n * phi^-2n)
+// n * log_b(phi) is taken as an exact two-product against a double-double
+// constant, and only its fractional part goes through a polynomial. This is
+// what keeps the leading digits accurate for indices far beyond the exponent
+// range of a double.
+//
+// Error bounds, measured by the approx test against exact bignum terms:
+// - FibApproxBatch: within 2 ulp up to F(1476), the largest finite double,
+//   and rounds to the exact integer below FibApproxExactIndex
+// - FibLog10Batch: within 1 ulp
+// - FibLeadingBatch: mantissa within 4.5e-16 relative error up to F(100000).
+//   Further out, up to any n < 2^52, the fraction of n * log10(phi) alone
+//   is good to about 2^-52
+
+// Largest n where F(n) is a finite double
+constexpr std::uint64_t FibApproxMaxIndex = 1476;
+
+// Rounding FibApproxBatch to the nearest integer is exact for all n below this
+constexpr std::uint64_t FibApproxExactIndex = 76;
+
+// The log domain takes n as an exact double
+constexpr std::uint64_t FibApproxMaxLogIndex = (1ULL << 52) - 1;
+
+namespace FibApproxImpl
+{
+using namespace FibSimd;
+
+// log2(phi), log10(phi) as double-doubles
+constexpr double Log2PhiHigh   = 0.6942419136306173;
+constexpr double Log2PhiLow    = 3.284551552634979e-17;
+constexpr double Log10PhiHigh  = 0.20898764024997873;
+constexpr double Log10PhiLow   = -6.831685870127068e-19;
+constexpr double Log2Sqrt5     = 1.160964047443681;
+constexpr double Log10Sqrt5    = 0.34948500216800943;
+constexpr double Log2Of10      = 3.321928094887362;
+constexpr double TwoOverLn10   = 0.8685889638065036;
+constexpr double MinusTwoLog2Phi = -1.3884838272612345;
+
+// Fractions of log10 this close to the next integer snap to it, so that
+// F(1) = F(2) = 1 come out as 1e0 rather than 9.99...e-1
+constexpr double SnapEpsilon = 1.0 / (1ULL << 50);
+
+// 2^k * 2^f, for integral k in [-1022, 1023] and f in [0, 1)
+// 2^f = sqrt(2) * e^(g * ln(2)) with g = f - 0.5, as a Taylor polynomial
+// that is exact to within an ulp over |g| <= 0.5
+inline Doubles Pow2( Doubles k, Doubles f )
+{
+	const Doubles g = Sub(f, Set1(0.5));
+	Doubles Poly = Set1(1.936268922627128e-12);
+	Poly = Fma(Poly, g, Set1(3.631479244252046e-11));
+	Poly = Fma(Poly, g, Set1(6.286940516128353e-10));
+	Poly = Fma(Poly, g, Set1(9.977151695480503e-09));
+	Poly = Fma(Poly, g, Set1(1.4393987273266634e-07));
+	Poly = Fma(Poly, g, Set1(1.8689520651984563e-06));
+	Poly = Fma(Poly, g, Set1(2.1570623008967995e-05));
+	Poly = Fma(Poly, g, Set1(0.00021783881590746449));
+	Poly = Fma(Poly, g, Set1(0.001885649876536937));
+	Poly = Fma(Poly, g, Set1(0.013602088628663626));
+	Poly = Fma(Poly, g, Set1(0.0784946632412207));
+	Poly = Fma(Poly, g, Set1(0.3397315841830749));
+	Poly = Fma(Poly, g, Set1(0.9802581434685472));
+	Poly = Fma(Poly, g, Set1(1.4142135623730951));
+	// Biased exponent straight into the exponent field
+	const Doubles Scale = AsDoubles(Shl<52>(AsWords(Add(k, Set1(Magic + 1023.0)))));
+	return Mul(Poly, Scale);
+}
+
+// n * (High + Low) - C, split into an integral k and a fraction f in [0, 1)
+inline void SplitLog( Doubles n, double High, double Low, double C, Doubles& k, Doubles& f )
+{
+	const Doubles Product = Mul(n, Set1(High));
+	const Doubles Error   = Fma(n, Set1(High), Sub(Set1(0.0), Product));
+	k = Floor(Product);
+	f = Add(Sub(Product, k), Add(Error, Fma(n, Set1(Low), Set1(-C))));
+	const Doubles Carry = Floor(f);
+	k = Add(k, Carry);
+	f = Sub(f, Carry);
+}
+
+// (-1)^n * phi^-2n, the relative weight of the psi^n term
+inline Doubles PsiRatio( Words n, Doubles nd )
+{
+	// Anything below 2^-1000 might as well be zero
+	const Doubles t = Max(Mul(nd, Set1(MinusTwoLog2Phi)), Set1(-1000.0));
+	const Doubles k = Floor(t);
+	return AsDoubles(Xor(AsWords(Pow2(k, Sub(t, k))), Shl<63>(n)));
+}
+
+// F(n) as a double
+inline void Approx( const std::uint64_t* N, double* Out )
+{
+	const Words n = LoadWords(N);
+	const Doubles nd = ToDoubles(n);
+	Doubles k, f;
+	SplitLog(nd, Log2PhiHigh, Log2PhiLow, Log2Sqrt5, k, f);
+	const Doubles Phi = Pow2(k, f);
+	Doubles Value = Fma(Sub(Set1(0.0), Phi), PsiRatio(n, nd), Phi);
+	Value = Select(IsZero(n), Set1(0.0), Value);
+	Value = Select(Above(n, FibApproxMaxIndex), Set1(std::numeric_limits<double>::infinity()), Value);
+	Store(Out, Value);
+}
+
+// log10 F(n) split into an integral k and a fraction f in [0, 1)
+inline void Log10( Words n, Doubles& k, Doubles& f )
+{
+	const Doubles nd = ToDoubles(n);
+	SplitLog(nd, Log10PhiHigh, Log10PhiLow, Log10Sqrt5, k, f);
+
+	// log10(1 - r) = 2 * atanh(s) / ln(10) with s = -r / (2 - r), where
+	// |s| <= 0.161 for all n >= 1
+	const Doubles r = PsiRatio(n, nd);
+	const Doubles s = Div(Sub(Set1(0.0), r), Sub(Set1(2.0), r));
+	const Doubles s2 = Mul(s, s);
+	Doubles Poly = Set1(1.0 / 21.0);
+	Poly = Fma(Poly, s2, Set1(1.0 / 19.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 17.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 15.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 13.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 11.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 9.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 7.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 5.0));
+	Poly = Fma(Poly, s2, Set1(1.0 / 3.0));
+	Poly = Fma(Poly, s2, Set1(1.0));
+	f = Fma(Mul(s, Set1(TwoOverLn10)), Poly, f);
+
+	const Mask Down = Less(f, Set1(0.0));
+	k = Select(Down, Sub(k, Set1(1.0)), k);
+	f = Select(Down, Add(f, Set1(1.0)), f);
+	const Mask Up = GreaterEqual(f, Set1(1.0 - SnapEpsilon));
+	k = Select(Up, Add(k, Set1(1.0)), k);
+	f = Select(Up, Max(Sub(f, Set1(1.0)), Set1(0.0)), f);
+}
+
+inline void Log10( const std::uint64_t* N, double* Out )
+{
+	const Words n = LoadWords(N);
+	Doubles k, f;
+	Log10(n, k, f);
+	Store(Out, Select(IsZero(n), Set1(-std::numeric_limits<double>::infinity()), Add(k, f)));
+}
+
+inline void Leading( const std::uint64_t* N, double* Mantissa, std::uint64_t* Exponent )
+{
+	const Words n = LoadWords(N);
+	Doubles k, f;
+	Log10(n, k, f);
+	// 10^f = 2^(f * log2(10)), with f * log2(10) in [0, 3.33)
+	const Doubles t = Mul(f, Set1(Log2Of10));
+	const Doubles j = Floor(t);
+	const Mask Zero = IsZero(n);
+	Store(Mantissa, Select(Zero, Set1(0.0), Pow2(j, Sub(t, j))));
+	Store(Exponent, Select(Zero, Splat(0), ToWords(k)));
+}
+
+// Copies a partial batch into a full one, padded with zeros
+inline void PadTail( const std::uint64_t* N, std::size_t Count, std::uint64_t* Tail )
+{
+	for( std::size_t i = 0; i < Width; ++i )
+	{
+		Tail[i] = i < Count ? N[i] : 0;
+	}
+}
+}
+
+// Out[i] ~ F(N[i]), +inf past FibApproxMaxIndex
+inline void FibApproxBatch( const std::uint64_t* N, double* Out, std::size_t Count )
+{
+	using namespace FibApproxImpl;
+	std::size_t i = 0;
+	for( ; i + Width <= Count; i += Width )
+	{
+		Approx(N + i, Out + i);
+	}
+	if( i < Count )
+	{
+		std::uint64_t Tail[Width];
+		double Result[Width];
+		PadTail(N + i, Count - i, Tail);
+		Approx(Tail, Result);
+		std::copy(Result, Result + (Count - i), Out + i);
+	}
+}
+
+// Out[i] ~ log10 F(N[i]), -inf for F(0), N[i] must not exceed FibApproxMaxLogIndex
+inline void FibLog10Batch( const std::uint64_t* N, double* Out, std::size_t Count )
+{
+	using namespace FibApproxImpl;
+	std::size_t i = 0;
+	for( ; i + Width <= Count; i += Width )
+	{
+		Log10(N + i, Out + i);
+	}
+	if( i < Count )
+	{
+		std::uint64_t Tail[Width];
+		double Result[Width];
+		PadTail(N + i, Count - i, Tail);
+		Log10(Tail, Result);
+		std::copy(Result, Result + (Count - i), Out + i);
+	}
+}
+
+// F(N[i]) ~ Mantissa[i] * 10^Exponent[i] with Mantissa[i] in [1, 10), and a
+// Mantissa of 0 for F(0). N[i] must not exceed FibApproxMaxLogIndex
+inline void FibLeadingBatch(
+	const std::uint64_t* N, double* Mantissa, std::uint64_t* Exponent, std::size_t Count
+)
+{
+	using namespace FibApproxImpl;
+	std::size_t i = 0;
+	for( ; i + Width <= Count; i += Width )
+	{
+		Leading(N + i, Mantissa + i, Exponent + i);
+	}
+	if( i < Count )
+	{
+		std::uint64_t Tail[Width];
+		double TailMantissa[Width];
+		std::uint64_t TailExponent[Width];
+		PadTail(N + i, Count - i, Tail);
+		Leading(Tail, TailMantissa, TailExponent);
+		std::copy(TailMantissa, TailMantissa + (Count - i), Mantissa + i);
+		std::copy(TailExponent, TailExponent + (Count - i), Exponent + i);
+	}
+}
@@ -0,0 +1,149 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+
+#include <immintrin.h>
+
+#include "FibKernels.hpp"
+#include "WideInt.hpp"
+
+// Batched evaluation of independent F(n) queries
+//
+// Fast doubling has no data-dependent control flow other than the bits of n,
+// so several queries can walk their bits in lockstep, one query per lane.
+// Shorter indices just have leading zero bits, which keep (F(0), F(1)) as is.
+
+namespace FibBatchImpl
+{
+inline std::uint64_t BitWidth( std::uint64_t n )
+{
+	#ifdef _MSC_VER
+	return n ? 64 - __lzcnt64(n) : 0;
+	#else
+	return n ? 64 - __builtin_clzll(n) : 0;
+	#endif
+}
+
+#if defined(__AVX512F__) && defined(__AVX512DQ__)
+constexpr std::size_t Width = 8;
+
+inline void Evaluate( const std::uint64_t* N, std::uint64_t* Out )
+{
+	const __m512i n = _mm512_loadu_si512(N);
+	const std::uint64_t h = BitWidth(
+		N[0] | N[1] | N[2] | N[3] | N[4] | N[5] | N[6] | N[7]
+	);
+
+	__m512i a = _mm512_setzero_si512();
+	__m512i b = _mm512_set1_epi64(1);
+	for( std::uint64_t mask = h ? 1ULL << (h - 1) : 0; mask; mask >>= 1 )
+	{
+		const __m512i c = _mm512_mullo_epi64(
+			a, _mm512_sub_epi64(_mm512_add_epi64(b, b), a)
+		);
+		const __m512i d = _mm512_add_epi64(
+			_mm512_mullo_epi64(a, a), _mm512_mullo_epi64(b, b)
+		);
+		const __mmask8 Odd = _mm512_test_epi64_mask(
+			n, _mm512_set1_epi64(static_cast<std::int64_t>(mask))
+		);
+		a = _mm512_mask_blend_epi64(Odd, c, d);
+		b = _mm512_mask_blend_epi64(Odd, d, _mm512_add_epi64(c, d));
+	}
+	_mm512_storeu_si512(Out, a);
+}
+#else
+constexpr std::size_t Width = 4;
+
+inline void Evaluate( const std::uint64_t* N, std::uint64_t* Out )
+{
+	const __m256i n = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(N));
+	const std::uint64_t h = BitWidth(N[0] | N[1] | N[2] | N[3]);
+
+	__m256i a = _mm256_setzero_si256();
+	__m256i b = _mm256_set1_epi64x(1);
+	for( std::uint64_t mask = h ? 1ULL << (h - 1) : 0; mask; mask >>= 1 )
+	{
+		const __m256i c = MulLo64x4(
+			a, _mm256_sub_epi64(_mm256_add_epi64(b, b), a)
+		);
+		const __m256i d = _mm256_add_epi64(MulLo64x4(a, a), MulLo64x4(b, b));
+		const __m256i Bit = _mm256_set1_epi64x(static_cast<std::int64_t>(mask));
+		const __m256i Odd = _mm256_cmpeq_epi64(_mm256_and_si256(n, Bit), Bit);
+		a = _mm256_blendv_epi8(c, d, Odd);
+		b = _mm256_blendv_epi8(d, _mm256_add_epi64(c, d), Odd);
+	}
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(Out), a);
+}
+#endif
+}
+
+// Out[i] = F(N[i]) mod 2^64
+inline void FibBatch64( const std::uint64_t* N, std::uint64_t* Out, std::size_t Count )
+{
+	std::size_t i = 0;
+	for( ; i + FibBatchImpl::Width <= Count; i += FibBatchImpl::Width )
+	{
+		FibBatchImpl::Evaluate(N + i, Out + i);
+	}
+	for( ; i < Count; ++i )
+	{
+		Out[i] = FibPair<std::uint64_t>(N[i]).first;
+	}
+}
+
+// (A * B) mod Modulus
+inline std::uint64_t MulMod( std::uint64_t A, std::uint64_t B, std::uint64_t Modulus )
+{
+	std::uint64_t High;
+	const std::uint64_t Low = WideOps::MulWide(A, B, High);
+	#ifdef _MSC_VER
+	std::uint64_t Remainder;
+	_udiv128(High % Modulus, Low, Modulus, &Remainder);
+	return Remainder;
+	#else
+	return static_cast<std::uint64_t>(
+		((static_cast<unsigned __int128>(High) << 64) | Low) % Modulus
+	);
+	#endif
+}
+
+// Fast doubling mod an arbitrary Modulus, a Modulus of 0 means 2^64
+// Returns the pair F(n), F(n + 1)
+inline std::pair<std::uint64_t, std::uint64_t> FibModPair(
+	std::uint64_t n, std::uint64_t Modulus
+)
+{
+	if( Modulus == 0 )
+	{
+		return FibPair<std::uint64_t>(n);
+	}
+	std::uint64_t a = 0;
+	std::uint64_t b = 1 % Modulus;
+	for( std::uint64_t mask = n ? 1ULL << (FibBatchImpl::BitWidth(n) - 1) : 0; mask; mask >>= 1 )
+	{
+		// 2 * F(k+1) - F(k), kept within [0, Modulus)
+		const std::uint64_t Twice = b >= Modulus - b ? b - (Modulus - b) : b + b;
+		const std::uint64_t c = MulMod(a, Twice >= a ? Twice - a : Twice + (Modulus - a), Modulus);
+		const std::uint64_t aa = MulMod(a, a, Modulus);
+		const std::uint64_t bb = MulMod(b, b, Modulus);
+		const std::uint64_t d = aa >= Modulus - bb ? aa - (Modulus - bb) : aa + bb;
+		if( mask & n )
+		{
+			a = d;
+			b = c >= Modulus - d ? c - (Modulus - d) : c + d;
+		}
+		else
+		{
+			a = c;
+			b = d;
+		}
+	}
+	return std::make_pair(a, b);
+}
+
+inline std::uint64_t FibMod( std::uint64_t n, std::uint64_t Modulus )
+{
+	return FibModPair(n, Modulus).first;
+}
@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <utility>
+#include <type_traits>
+
+#include <immintrin.h>
+
+// Shared fibonacci kernels
+//
+// The SIMD kernels are the same [ 4 4 1 0 ] [ 1 4 2 0 ] [ 2 1 0 0 ] [ 1 1 0 0 ]
+// matrix from the readme, where every coefficient is zero or a power of two
+// so the product lowers into broadcasts, variable shifts, and adds.
+
+// Advances four consecutive terms F(n + 0..3)(mod 2^32), lowest lane first,
+// into F(n + 4..7)
+inline __m128i FibNext4( __m128i FibState )
+{
+	// Shift amounts for F(n+1), F(n+2), F(n+3), ~0 meaning a coefficient of 0
+	// F(n) is not needed at all
+	const __m128i NextState[3] = {
+		_mm_set_epi32( 0,  1, ~0, ~0),
+		_mm_set_epi32( 2,  2,  0,  0),
+		_mm_set_epi32( 2,  0,  1,  0)
+	};
+
+	__m128i Result = _mm_setzero_si128();
+	FibState = _mm_alignr_epi8(FibState, FibState, 4);
+	for( std::size_t i = 0; i < 3; ++i )
+	{
+		const __m128i Product = _mm_sllv_epi32(
+			_mm_broadcastd_epi32(FibState), NextState[i]
+		);
+		FibState = _mm_alignr_epi8(_mm_setzero_si128(), FibState, 4);
+		Result = _mm_add_epi32(Result, Product);
+	}
+	return Result;
+}
+
+// Same as FibNext4, on four 64-bit lanes(mod 2^64)
+inline __m256i FibNext4x64( __m256i FibState )
+{
+	const __m256i Shift1 = _mm256_set_epi64x( 0,  1, ~0, ~0);
+	const __m256i Shift2 = _mm256_set_epi64x( 2,  2,  0,  0);
+	const __m256i Shift3 = _mm256_set_epi64x( 2,  0,  1,  0);
+
+	const __m256i Term1 = _mm256_permute4x64_epi64(FibState, 0b01'01'01'01);
+	const __m256i Term2 = _mm256_permute4x64_epi64(FibState, 0b10'10'10'10);
+	const __m256i Term3 = _mm256_permute4x64_epi64(FibState, 0b11'11'11'11);
+
+	return _mm256_add_epi64(
+		_mm256_sllv_epi64(Term1, Shift1),
+		_mm256_add_epi64(
+			_mm256_sllv_epi64(Term2, Shift2),
+			_mm256_sllv_epi64(Term3, Shift3)
+		)
+	);
+}
+
+// Low 64 bits of the lane-wise product of four 64-bit lanes
+inline __m256i MulLo64x4( __m256i A, __m256i B )
+{
+	#if defined(__AVX512DQ__) && defined(__AVX512VL__)
+	return _mm256_mullo_epi64(A, B);
+	#else
+	// lo(a) * lo(b) + ((hi(a) * lo(b) + lo(a) * hi(b)) << 32)
+	const __m256i Low = _mm256_mul_epu32(A, B);
+	const __m256i Cross = _mm256_add_epi64(
+		_mm256_mul_epu32(_mm256_srli_epi64(A, 32), B),
+		_mm256_mul_epu32(A, _mm256_srli_epi64(B, 32))
+	);
+	return _mm256_add_epi64(Low, _mm256_slli_epi64(Cross, 32));
+	#endif
+}
+
+// Fast doubling(mod 2^32 or 2^64, by the width of T)
+// Returns the pair F(n), F(n + 1)
+template< typename T >
+std::pair<T, T> FibPair( std::uint64_t n )
+{
+	static_assert(
+		std::is_same<T, std::uint32_t>::value || std::is_same<T, std::uint64_t>::value,
+		"Only 32-bit and 64-bit unsigned terms are supported"
+	);
+	T a = 0; // F(0) = 0
+	T b = 1; // F(1) = 1
+	if( n == 0 )
+	{
+		return std::make_pair(a, b);
+	}
+	#ifdef _MSC_VER
+	const std::uint64_t h = 64 - __lzcnt64(n);
+	#else
+	const std::uint64_t h = 64 - __builtin_clzll(n);
+	#endif
+	for( std::uint64_t mask = 1ULL << (h - 1); mask; mask >>= 1 )
+	{
+		const T c = a * (2 * b - a); // F(2k) = F(k) * [ 2 * F(k+1) – F(k) ]
+		const T d = a * a + b * b;   // F(2k+1) = F(k)^2 + F(k+1)^2
+		if( mask & n )
+		{
+			a = d;
+			b = c + d;
+		}
+		else
+		{
+			a = c;
+			b = d;
+		}
+	}
+	return std::make_pair(a, b);
+}
+
+// State vector of F(n + 0..3)(mod 2^64) for FibNext4x64, from F(n), F(n + 1)
+inline __m256i FibState4x64( std::uint64_t Term0, std::uint64_t Term1 )
+{
+	const std::uint64_t Term2 = Term0 + Term1;
+	const std::uint64_t Term3 = Term1 + Term2;
+	return _mm256_set_epi64x(Term3, Term2, Term1, Term0);
+}
+
+inline __m256i FibState4x64( std::uint64_t n )
+{
+	const auto Pair = FibPair<std::uint64_t>(n);
+	return FibState4x64(Pair.first, Pair.second);
+}
+
+// Writes F(Start + 0..Count-1)(mod 2^64) into Out, Count must be a multiple
+// of four
+inline void FibGenerate64( std::uint64_t Start, std::uint64_t* Out, std::size_t Count )
+{
+	__m256i FibState = FibState4x64(Start);
+	for( std::size_t i = 0; i < Count; i += 4 )
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + i), FibState);
+		FibState = FibNext4x64(FibState);
+	}
+}
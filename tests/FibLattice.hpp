@@ -0,0 +1,510 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <stdexcept>
+
+#include <immintrin.h>
+
+#include "FibKernels.hpp"
+#include "FibBatch.hpp"
+#include "FibSimd.hpp"
+
+// Fibonacci lattice point sets for quasi-Monte Carlo integration
+//
+// - FibLattice2D: the F(m) points (i / F(m), frac(i * F(m - 1) / F(m))) of the
+//   unit square
+// - FibSphere: N points of the unit sphere on a golden-angle spiral, at
+//   z = 1 - (2i + 1) / N and a longitude of i golden angles
+//
+// Neither ever multiplies the index into a fraction. The lattice row
+// i * F(m - 1) mod F(m) is carried as an exact integer that steps by a
+// constant and wraps, and the spiral angle is a 64-bit fixed-point turn
+// count that steps by 2^64 / phi^2 and wraps on its own, so the points stay
+// exact for any index rather than drifting with the size of i * phi.
+//
+// Points come out as doubles, either one array per coordinate or one
+// interleaved array. FibParallelRanges spreads a set over threads and
+// FibStreamPoints hands sets too large for memory over block by block.
+
+// F(m) below 2^52, so that every numerator converts to a double exactly
+constexpr std::size_t FibLatticeMaxOrder = 76;
+
+namespace FibLatticeImpl
+{
+// 2^64 / phi^2, the golden angle in 64-bit fixed-point turns
+constexpr std::uint64_t GoldenTurn = 0x61C8864680B583EBULL;
+
+constexpr double TwoPi = 6.283185307179586;
+
+using namespace FibSimd;
+
+#if defined(__AVX512F__)
+// x0 y0 x1 y1 ..., the unpacks masked for GCC 12 as in FibSimd.hpp
+inline void StoreInterleaved( double* Out, const Doubles (&Point)[2] )
+{
+	const Doubles X = Point[0], Y = Point[1];
+	const Doubles Even = _mm512_mask_unpacklo_pd(X, 0xFF, X, Y);
+	const Doubles Odd  = _mm512_mask_unpackhi_pd(X, 0xFF, X, Y);
+	_mm512_storeu_pd(Out + 0, _mm512_permutex2var_pd(Even, _mm512_set_epi64(11, 10, 3, 2, 9, 8, 1, 0), Odd));
+	_mm512_storeu_pd(Out + 8, _mm512_permutex2var_pd(Even, _mm512_set_epi64(15, 14, 7, 6, 13, 12, 5, 4), Odd));
+}
+
+// x0 y0 z0 x1 y1 z1 ..., the x and y lanes of each vector first and the z
+// lanes merged into the gaps
+inline void StoreInterleaved( double* Out, const Doubles (&Point)[3] )
+{
+	const Doubles X = Point[0], Y = Point[1], Z = Point[2];
+	_mm512_storeu_pd(
+		Out + 0,
+		_mm512_mask_permutexvar_pd(
+			_mm512_permutex2var_pd(X, _mm512_set_epi64(10, 2, 0, 9, 1, 0, 8, 0), Y),
+			0x24, _mm512_set_epi64(0, 0, 1, 0, 0, 0, 0, 0), Z
+		)
+	);
+	_mm512_storeu_pd(
+		Out + 8,
+		_mm512_mask_permutexvar_pd(
+			_mm512_permutex2var_pd(X, _mm512_set_epi64(5, 0, 12, 4, 0, 11, 3, 0), Y),
+			0x49, _mm512_set_epi64(0, 4, 0, 0, 3, 0, 0, 2), Z
+		)
+	);
+	_mm512_storeu_pd(
+		Out + 16,
+		_mm512_mask_permutexvar_pd(
+			_mm512_permutex2var_pd(X, _mm512_set_epi64(0, 15, 7, 0, 14, 6, 0, 13), Y),
+			0x92, _mm512_set_epi64(7, 0, 0, 6, 0, 0, 5, 0), Z
+		)
+	);
+}
+#else
+inline void StoreInterleaved( double* Out, const Doubles (&Point)[2] )
+{
+	const Doubles Even = _mm256_unpacklo_pd(Point[0], Point[1]);
+	const Doubles Odd  = _mm256_unpackhi_pd(Point[0], Point[1]);
+	_mm256_storeu_pd(Out + 0, _mm256_permute2f128_pd(Even, Odd, 0x20));
+	_mm256_storeu_pd(Out + 4, _mm256_permute2f128_pd(Even, Odd, 0x31));
+}
+
+inline void StoreInterleaved( double* Out, const Doubles (&Point)[3] )
+{
+	// x0 y0 x2 y2, x1 y1 x3 y3, then the pairs around them with z
+	const Doubles Even = _mm256_unpacklo_pd(Point[0], Point[1]);
+	const Doubles Odd  = _mm256_unpackhi_pd(Point[0], Point[1]);
+	// z0 x1 z2 x3, y1 z1 y3 z3
+	const Doubles ZX = _mm256_unpacklo_pd(Point[2], Odd);
+	const Doubles YZ = _mm256_unpackhi_pd(Odd, Point[2]);
+	_mm256_storeu_pd(Out + 0, _mm256_permute2f128_pd(Even, ZX, 0x20));
+	_mm256_storeu_pd(Out + 4, _mm256_permute2f128_pd(YZ, Even, 0x30));
+	_mm256_storeu_pd(Out + 8, _mm256_permute2f128_pd(ZX, YZ, 0x31));
+}
+#endif
+
+// The top 52 bits of a 64-bit fixed-point fraction as a double in [0, 1)
+inline Doubles FractionToDoubles( Words Fraction )
+{
+	return Sub(AsDoubles(Or(Shr<12>(Fraction), AsWords(Set1(1.0)))), Set1(1.0));
+}
+
+// cos(2 pi t), sin(2 pi t) for t in [0, 1)
+// Reduced to a in [-pi/4, pi/4] around the nearest quarter turn q, where
+// t - q / 4 is exact, then Taylor series out to well below an ulp
+inline void SinCosTurns( Doubles t, Doubles& Cos, Doubles& Sin )
+{
+	const Doubles q = Round(Mul(t, Set1(4.0)));
+	const Doubles a = Mul(Fma(q, Set1(-0.25), t), Set1(TwoPi));
+	const Doubles a2 = Mul(a, a);
+
+	Doubles S = Set1(1.0 / 1307674368000.0);
+	S = Fma(S, a2, Set1(-1.0 / 6227020800.0));
+	S = Fma(S, a2, Set1(1.0 / 39916800.0));
+	S = Fma(S, a2, Set1(-1.0 / 362880.0));
+	S = Fma(S, a2, Set1(1.0 / 5040.0));
+	S = Fma(S, a2, Set1(-1.0 / 120.0));
+	S = Fma(S, a2, Set1(1.0 / 6.0));
+	// a - a^3 * (1/6 - ...)
+	S = Sub(a, Mul(Mul(a, a2), S));
+
+	Doubles C = Set1(1.0 / 20922789888000.0);
+	C = Fma(C, a2, Set1(-1.0 / 87178291200.0));
+	C = Fma(C, a2, Set1(1.0 / 479001600.0));
+	C = Fma(C, a2, Set1(-1.0 / 3628800.0));
+	C = Fma(C, a2, Set1(1.0 / 40320.0));
+	C = Fma(C, a2, Set1(-1.0 / 720.0));
+	C = Fma(C, a2, Set1(1.0 / 24.0));
+	C = Fma(C, a2, Set1(-0.5));
+	C = Fma(C, a2, Set1(1.0));
+
+	// Quarter turns 1 and 3 swap the two, 1 and 2 negate the cosine, 2 and 3
+	// the sine. q of 4 is a whole turn, the same as 0
+	const Mask Swap = Either(Equal(q, Set1(1.0)), Equal(q, Set1(3.0)));
+	const Doubles Zero = Set1(0.0);
+	const Doubles SwappedC = Select(Swap, S, C);
+	const Doubles SwappedS = Select(Swap, C, S);
+	Cos = Select(Inside(q, 0.5, 2.5), Sub(Zero, SwappedC), SwappedC);
+	Sin = Select(Inside(q, 1.5, 3.5), Sub(Zero, SwappedS), SwappedS);
+}
+
+// Splits off the few points before the outputs reach a whole vector's
+// alignment, so that the bulk of the stores never straddle a cache line.
+// Coordinate arrays that sit at different offsets within a vector cannot
+// all be aligned at once, the split then aligns as many of them as it can.
+// Kernel(First, Count, Coords, Interleaved) runs on each part
+template< std::size_t Dims, typename KernelT >
+inline void Aligned(
+	std::uint64_t First, std::size_t Count,
+	double* const (&Coords)[Dims], double* Interleaved, KernelT&& Kernel
+)
+{
+	const std::size_t Stride = Interleaved ? Dims : 1;
+	std::size_t Head = 0, MostAligned = 0;
+	for( std::size_t h = 0; h < Width; ++h )
+	{
+		std::size_t Matches = 0;
+		for( std::size_t d = 0; d < (Interleaved ? 1 : Dims); ++d )
+		{
+			const double* Out = Interleaved ? Interleaved : Coords[d];
+			Matches += reinterpret_cast<std::uintptr_t>(Out + h * Stride) % (Width * sizeof(double)) == 0;
+		}
+		if( Matches > MostAligned )
+		{
+			Head = h;
+			MostAligned = Matches;
+		}
+	}
+	Head = std::min(Head, Count);
+	if( Head )
+	{
+		Kernel(First, Head, Coords, Interleaved);
+	}
+	double* Rest[Dims];
+	for( std::size_t d = 0; d < Dims; ++d )
+	{
+		Rest[d] = Coords[d] ? Coords[d] + Head : nullptr;
+	}
+	Kernel(First + Head, Count - Head, Rest, Interleaved ? Interleaved + Head * Dims : nullptr);
+}
+
+// Width points at a time, only the first Count of them at the end
+// Coordinates are written out one array per coordinate, or interleaved
+template< std::size_t Dims >
+inline void Write(
+	const Doubles (&Points)[Dims], std::size_t Count,
+	double* const (&Coords)[Dims], double* Interleaved, std::size_t Offset
+)
+{
+	if( Count == Width )
+	{
+		if( Interleaved )
+		{
+			StoreInterleaved(Interleaved + Offset * Dims, Points);
+			return;
+		}
+		for( std::size_t d = 0; d < Dims; ++d )
+		{
+			Store(Coords[d] + Offset, Points[d]);
+		}
+		return;
+	}
+	alignas(64) double Tile[Dims][Width];
+	for( std::size_t d = 0; d < Dims; ++d )
+	{
+		Store(Tile[d], Points[d]);
+	}
+	for( std::size_t i = 0; i < Count; ++i )
+	{
+		for( std::size_t d = 0; d < Dims; ++d )
+		{
+			if( Interleaved )
+			{
+				Interleaved[(Offset + i) * Dims + d] = Tile[d][i];
+			}
+			else
+			{
+				Coords[d][Offset + i] = Tile[d][i];
+			}
+		}
+	}
+}
+}
+
+// The F(m) point Fibonacci lattice of the unit square
+class FibLattice2D
+{
+public:
+	static constexpr std::size_t Dims = 2;
+
+	explicit FibLattice2D( std::size_t m )
+	{
+		if( m < 2 || m > FibLatticeMaxOrder )
+		{
+			throw std::invalid_argument("Lattice order out of range");
+		}
+		const auto Pair = FibPair<std::uint64_t>(m - 1);
+		Previous = Pair.first;
+		Points = Pair.second;
+	}
+
+	std::uint64_t Size() const
+	{
+		return Points;
+	}
+
+	// Points First..First + Count - 1, X[0] and Y[0] being point First
+	// Throws std::out_of_range unless they all lie below Size()
+	void Generate( std::uint64_t First, std::size_t Count, double* X, double* Y ) const
+	{
+		double* const Coords[Dims] = { X, Y };
+		Aligned(First, Count, Coords, nullptr);
+	}
+
+	// Same, as x0 y0 x1 y1 ...
+	void Generate( std::uint64_t First, std::size_t Count, double* XY ) const
+	{
+		double* const Coords[Dims] = { nullptr, nullptr };
+		Aligned(First, Count, Coords, XY);
+	}
+
+	void Generate( std::uint64_t First, std::size_t Count, double* const (&Coords)[Dims] ) const
+	{
+		Aligned(First, Count, Coords, nullptr);
+	}
+
+private:
+	void Aligned(
+		std::uint64_t First, std::size_t Count,
+		double* const (&Coords)[Dims], double* Interleaved
+	) const
+	{
+		if( First > Points || Count > Points - First )
+		{
+			throw std::out_of_range("Points past the end of the set");
+		}
+		FibLatticeImpl::Aligned(
+			First, Count, Coords, Interleaved,
+			[this]( std::uint64_t Begin, std::size_t Part, double* const (&Out)[Dims], double* OutInterleaved )
+			{
+				Run(Begin, Part, Out, OutInterleaved);
+			}
+		);
+	}
+
+	void Run(
+		std::uint64_t First, std::size_t Count,
+		double* const (&Coords)[Dims], double* Interleaved
+	) const
+	{
+		using namespace FibLatticeImpl;
+		// i and i * F(m - 1) mod F(m) of every lane, stepped by Width
+		const Words Lane = Lanes();
+		alignas(64) std::uint64_t Row[Width];
+		for( std::size_t j = 0; j < Width; ++j )
+		{
+			Row[j] = MulMod((First + j) % Points, Previous, Points);
+		}
+		Words Index = AddWords(Splat(First), Lane);
+		Words Numerator = LoadWords(Row);
+		const Words IndexStep = Splat(Width);
+		const Words RowStep = Splat(MulMod(Width % Points, Previous, Points));
+		const Words Modulus = Splat(Points);
+		const Doubles Scale = Set1(1.0 / static_cast<double>(Points));
+
+		for( std::size_t i = 0; i < Count; i += Width )
+		{
+			const Doubles Point[Dims] = {
+				Mul(ToDoubles(Index), Scale),
+				Mul(ToDoubles(Numerator), Scale)
+			};
+			Write(Point, std::min(Width, Count - i), Coords, Interleaved, i);
+			Index = AddWords(Index, IndexStep);
+			Numerator = AddWords(Numerator, RowStep);
+			Numerator = Select(AtLeast(Numerator, Modulus), SubWords(Numerator, Modulus), Numerator);
+		}
+	}
+
+	std::uint64_t Previous;
+	std::uint64_t Points;
+};
+
+// N points of the unit sphere on a golden-angle spiral
+class FibSphere
+{
+public:
+	static constexpr std::size_t Dims = 3;
+
+	explicit FibSphere( std::uint64_t N )
+		: Points(N)
+	{
+		if( N == 0 || N >= (1ULL << 52) )
+		{
+			throw std::invalid_argument("Sphere size out of range");
+		}
+	}
+
+	std::uint64_t Size() const
+	{
+		return Points;
+	}
+
+	// Points First..First + Count - 1, X[0], Y[0] and Z[0] being point First
+	// Throws std::out_of_range unless they all lie below Size()
+	void Generate( std::uint64_t First, std::size_t Count, double* X, double* Y, double* Z ) const
+	{
+		double* const Coords[Dims] = { X, Y, Z };
+		Aligned(First, Count, Coords, nullptr);
+	}
+
+	// Same, as x0 y0 z0 x1 y1 z1 ...
+	void Generate( std::uint64_t First, std::size_t Count, double* XYZ ) const
+	{
+		double* const Coords[Dims] = { nullptr, nullptr, nullptr };
+		Aligned(First, Count, Coords, XYZ);
+	}
+
+	void Generate( std::uint64_t First, std::size_t Count, double* const (&Coords)[Dims] ) const
+	{
+		Aligned(First, Count, Coords, nullptr);
+	}
+
+private:
+	void Aligned(
+		std::uint64_t First, std::size_t Count,
+		double* const (&Coords)[Dims], double* Interleaved
+	) const
+	{
+		if( First > Points || Count > Points - First )
+		{
+			throw std::out_of_range("Points past the end of the set");
+		}
+		FibLatticeImpl::Aligned(
+			First, Count, Coords, Interleaved,
+			[this]( std::uint64_t Begin, std::size_t Part, double* const (&Out)[Dims], double* OutInterleaved )
+			{
+				Run(Begin, Part, Out, OutInterleaved);
+			}
+		);
+	}
+
+	void Run(
+		std::uint64_t First, std::size_t Count,
+		double* const (&Coords)[Dims], double* Interleaved
+	) const
+	{
+		using namespace FibLatticeImpl;
+		const Words Lane = Lanes();
+		Words Index = AddWords(Splat(First), Lane);
+		// i * 2^64 / phi^2 wraps into the fraction of a turn by itself
+		alignas(64) std::uint64_t Start[Width];
+		for( std::size_t j = 0; j < Width; ++j )
+		{
+			Start[j] = (First + j) * GoldenTurn;
+		}
+		Words Turn = LoadWords(Start);
+		const Words IndexStep = Splat(Width);
+		const Words TurnStep = Splat(Width * GoldenTurn);
+		// z = 1 - (2i + 1) / N
+		const Doubles ZScale = Set1(-2.0 / static_cast<double>(Points));
+		const Doubles ZOffset = Set1(1.0 - 1.0 / static_cast<double>(Points));
+		const Doubles One = Set1(1.0);
+
+		for( std::size_t i = 0; i < Count; i += Width )
+		{
+			const Doubles Z = Fma(ToDoubles(Index), ZScale, ZOffset);
+			const Doubles Radius = Sqrt(Mul(Sub(One, Z), Add(One, Z)));
+			Doubles Cos, Sin;
+			SinCosTurns(FractionToDoubles(Turn), Cos, Sin);
+			const Doubles Point[Dims] = { Mul(Radius, Cos), Mul(Radius, Sin), Z };
+			Write(Point, std::min(Width, Count - i), Coords, Interleaved, i);
+			Index = AddWords(Index, IndexStep);
+			Turn = AddWords(Turn, TurnStep);
+		}
+	}
+
+	std::uint64_t Points;
+};
+
+// Splits First..First + Count - 1 into one contiguous slice per thread, each
+// a multiple of the SIMD width but the last, and runs Work(First, Count) on
+// every slice. The calling thread takes the first slice itself
+template< typename WorkT >
+void FibParallelRanges( std::uint64_t First, std::uint64_t Count, std::size_t Threads, WorkT&& Work )
+{
+	constexpr std::uint64_t Width = FibLatticeImpl::Width;
+	Threads = std::max<std::size_t>(Threads, 1);
+	const std::uint64_t Slice = ((Count + Threads - 1) / Threads + Width - 1) / Width * Width;
+	std::vector<std::thread> Workers;
+	for( std::uint64_t Begin = Slice; Begin < Count; Begin += Slice )
+	{
+		Workers.emplace_back(
+			[&Work, First, Begin, Count, Slice]()
+			{
+				Work(First + Begin, std::min(Slice, Count - Begin));
+			}
+		);
+	}
+	Work(First, std::min(Slice, Count));
+	for( std::thread& Worker : Workers )
+	{
+		Worker.join();
+	}
+}
+
+// A block of a streamed point set, one array per coordinate
+struct FibPointBlock
+{
+	std::uint64_t First;
+	std::size_t Count;
+	const double* Coords[3];
+};
+
+// Generates a whole point set block by block for Consume(const FibPointBlock&)
+// without ever holding more than one block per thread
+// Blocks are handed out to the threads as they finish their last one, so
+// Consume is called from several threads at once and in no particular order
+template< typename SetT, typename ConsumeT >
+void FibStreamPoints(
+	const SetT& Set, std::size_t Threads, std::size_t BlockPoints, ConsumeT&& Consume
+)
+{
+	constexpr std::size_t Dims = SetT::Dims;
+	BlockPoints = std::max<std::size_t>(BlockPoints, 1);
+	const std::uint64_t Blocks = (Set.Size() + BlockPoints - 1) / BlockPoints;
+	std::atomic<std::uint64_t> NextBlock(0);
+
+	const auto Worker = [&]()
+	{
+		std::vector<double> Buffer(Dims * BlockPoints);
+		double* Coords[Dims];
+		FibPointBlock Block = {};
+		for( std::size_t d = 0; d < Dims; ++d )
+		{
+			Coords[d] = Buffer.data() + d * BlockPoints;
+			Block.Coords[d] = Coords[d];
+		}
+		for(
+			std::uint64_t b = NextBlock.fetch_add(1, std::memory_order_relaxed); b < Blocks;
+			b = NextBlock.fetch_add(1, std::memory_order_relaxed)
+		)
+		{
+			Block.First = b * BlockPoints;
+			Block.Count = static_cast<std::size_t>(std::min<std::uint64_t>(BlockPoints, Set.Size() - Block.First));
+			Set.Generate(Block.First, Block.Count, Coords);
+			Consume(static_cast<const FibPointBlock&>(Block));
+		}
+	};
+
+	std::vector<std::thread> Workers;
+	for( std::size_t i = 1; i < Threads; ++i )
+	{
+		Workers.emplace_back(Worker);
+	}
+	Worker();
+	for( std::thread& Thread : Workers )
+	{
+		Thread.join();
+	}
+}
@@ -0,0 +1,221 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <algorithm>
+
+#include <immintrin.h>
+
+// Fibonacci search over a sorted array of 64-bit keys, with lower_bound
+// semantics: the index of the first entry that is not less than the key
+//
+// The candidate answers [Lo, Lo + F(k)) are split at Lo + F(k - 1) - 1 into
+// F(k - 1) and F(k - 2) candidates, so every probe moves k down by one or
+// two. Probes only ever move by Fibonacci offsets, getting closer together
+// as k drops, and the last few candidates are settled by one SIMD compare.
+//
+// FibSearchBatch interleaves many keys: every key is a small state machine
+// that touches one line of the array per step and prefetches the line of its
+// next step, then hands over to the next key while that line is on its way.
+
+// Keys in flight, enough to cover the latency of DRAM with a probe each
+constexpr std::size_t FibSearchLanes = 16;
+
+namespace FibSearchImpl
+{
+// F(0..93) exactly, the terms that fit in 64 bits
+constexpr std::size_t Terms = 94;
+
+inline const std::array<std::uint64_t, Terms>& Table()
+{
+	static const auto Fib = []()
+	{
+		std::array<std::uint64_t, Terms> Fib;
+		Fib[0] = 0;
+		Fib[1] = 1;
+		for( std::size_t k = 2; k < Terms; ++k )
+		{
+			Fib[k] = Fib[k - 1] + Fib[k - 2];
+		}
+		return Fib;
+	}();
+	return Fib;
+}
+
+// Windows of up to this many candidates are compared all at once, that is
+// up to 7 entries
+constexpr std::uint64_t WindowCandidates = 8;
+
+// Candidates [Lo, Lo + Left + Right), to be split after the first Left
+// Left and Right are always F(k - 1) and F(k - 2) for the current k
+struct Range
+{
+	std::uint64_t Lo;
+	std::uint64_t Left;
+	std::uint64_t Right;
+};
+
+// The answers 0..Size as the smallest Fibonacci range that covers them
+inline Range Whole( std::uint64_t Size )
+{
+	const auto& Fib = Table();
+	const std::size_t k = static_cast<std::size_t>(
+		std::lower_bound(Fib.begin() + 2, Fib.end(), Size + 1) - Fib.begin()
+	);
+	return { 0, Fib[k - 1], Fib[k - 2] };
+}
+
+// Entries of Data[0..Count) that are less than Key, Count below 8
+inline std::uint64_t CountBelow( const std::uint64_t* Data, std::uint64_t Count, std::uint64_t Key )
+{
+	#if defined(__AVX512F__)
+	// Masked off lanes are never read, so the window may end anywhere
+	const __mmask8 Valid = static_cast<__mmask8>((1u << Count) - 1);
+	const __m512i Entries = _mm512_maskz_loadu_epi64(Valid, Data);
+	const __mmask8 Below = _mm512_mask_cmplt_epu64_mask(Valid, Entries, _mm512_set1_epi64(static_cast<long long>(Key)));
+	return _mm_popcnt_u32(Below);
+	#else
+	// No unsigned 64-bit compare, so both sides are flipped into signed order
+	const __m256i Sign = _mm256_set1_epi64x(static_cast<long long>(1ULL << 63));
+	const __m256i Flipped = _mm256_xor_si256(_mm256_set1_epi64x(static_cast<long long>(Key)), Sign);
+	const __m256i Lane = _mm256_set_epi64x(3, 2, 1, 0);
+	const __m256i Counts = _mm256_set1_epi64x(static_cast<long long>(Count));
+	const __m256i ValidLow  = _mm256_cmpgt_epi64(Counts, Lane);
+	const __m256i ValidHigh = _mm256_cmpgt_epi64(Counts, _mm256_add_epi64(Lane, _mm256_set1_epi64x(4)));
+	const __m256i Low  = _mm256_maskload_epi64(reinterpret_cast<const long long*>(Data), ValidLow);
+	const __m256i High = _mm256_maskload_epi64(reinterpret_cast<const long long*>(Data + 4), ValidHigh);
+	const __m256i BelowLow  = _mm256_and_si256(ValidLow, _mm256_cmpgt_epi64(Flipped, _mm256_xor_si256(Low, Sign)));
+	const __m256i BelowHigh = _mm256_and_si256(ValidHigh, _mm256_cmpgt_epi64(Flipped, _mm256_xor_si256(High, Sign)));
+	return static_cast<std::uint64_t>(
+		_mm_popcnt_u32(
+			_mm256_movemask_pd(_mm256_castsi256_pd(BelowLow))
+			| _mm256_movemask_pd(_mm256_castsi256_pd(BelowHigh)) << 4
+		)
+	);
+	#endif
+}
+
+// 1 if Data[Probe] < Key, else 0
+// Past the end counts as not less, as if padded with the largest key. The
+// load is clamped rather than skipped so that there is no branch to guess
+inline std::uint64_t ProbeLess(
+	const std::uint64_t* Data, std::uint64_t Size, std::uint64_t Probe, std::uint64_t Key
+)
+{
+	const std::uint64_t Entry = Data[std::min(Probe, Size - 1)];
+	return static_cast<std::uint64_t>(Probe < Size) & static_cast<std::uint64_t>(Entry < Key);
+}
+
+inline void Prefetch( const std::uint64_t* Address )
+{
+	_mm_prefetch(reinterpret_cast<const char*>(Address), _MM_HINT_T0);
+}
+}
+
+// std::lower_bound(Data, Data + Size, Key) - Data, one key at a time
+// Left branchy on purpose: alone, a speculated probe is the only prefetch
+inline std::uint64_t FibSearch( const std::uint64_t* Data, std::uint64_t Size, std::uint64_t Key )
+{
+	using namespace FibSearchImpl;
+	Range Candidates = Whole(Size);
+	while( Candidates.Left + Candidates.Right > WindowCandidates )
+	{
+		const std::uint64_t Probe = Candidates.Lo + Candidates.Left - 1;
+		const std::uint64_t Rest = Candidates.Left - Candidates.Right;
+		if( Probe < Size && Data[Probe] < Key )
+		{
+			// F(k - 2) candidates to the right, split into F(k - 3), F(k - 4)
+			Candidates = { Probe + 1, Rest, Candidates.Right - Rest };
+		}
+		else
+		{
+			Candidates = { Candidates.Lo, Candidates.Right, Rest };
+		}
+	}
+	return Candidates.Lo + CountBelow(
+		Data + Candidates.Lo, std::min(Candidates.Left + Candidates.Right - 1, Size - Candidates.Lo), Key
+	);
+}
+
+// Out[i] = std::lower_bound(Data, Data + Size, Keys[i]) - Data
+inline void FibSearchBatch(
+	const std::uint64_t* Data, std::uint64_t Size,
+	const std::uint64_t* Keys, std::uint64_t* Out, std::size_t Count
+)
+{
+	using namespace FibSearchImpl;
+	const Range Top = Whole(Size);
+
+	struct Slot
+	{
+		std::uint64_t Key;
+		Range Candidates;
+		std::size_t Index;
+	};
+	Slot Slots[FibSearchLanes];
+	std::size_t Active = 0;
+	std::size_t Next = 0;
+
+	// Whatever the slot touches on its next step: a probe, or the window
+	const auto PrefetchNext = [&]( const Range& Candidates )
+	{
+		const std::uint64_t Span = Candidates.Left + Candidates.Right;
+		if( Span > WindowCandidates )
+		{
+			Prefetch(Data + std::min(Candidates.Lo + Candidates.Left - 1, Size - 1));
+		}
+		else if( Candidates.Lo < Size )
+		{
+			// The window may straddle two lines
+			Prefetch(Data + Candidates.Lo);
+			Prefetch(Data + std::min(Candidates.Lo + Span - 2, Size - 1));
+		}
+	};
+
+	for( ; Active < FibSearchLanes && Next < Count; ++Active, ++Next )
+	{
+		Slots[Active] = { Keys[Next], Top, Next };
+		PrefetchNext(Top);
+	}
+
+	while( Active )
+	{
+		for( std::size_t i = 0; i < Active; )
+		{
+			Slot& Current = Slots[i];
+			Range& Candidates = Current.Candidates;
+			if( Candidates.Left + Candidates.Right > WindowCandidates )
+			{
+				// Same step as FibSearch, with the outcome as a mask since
+				// interleaved keys leave nothing for the predictor to learn
+				const std::uint64_t Probe = Candidates.Lo + Candidates.Left - 1;
+				const std::uint64_t Rest = Candidates.Left - Candidates.Right;
+				const std::uint64_t Less = 0 - ProbeLess(Data, Size, Probe, Current.Key);
+				Candidates.Lo += (Probe + 1 - Candidates.Lo) & Less;
+				Candidates.Left = (Candidates.Right & ~Less) | (Rest & Less);
+				Candidates.Right = (Rest & ~Less) | ((Candidates.Right - Rest) & Less);
+				PrefetchNext(Candidates);
+				++i;
+				continue;
+			}
+
+			Out[Current.Index] = Candidates.Lo + CountBelow(
+				Data + Candidates.Lo,
+				std::min(Candidates.Left + Candidates.Right - 1, Size - Candidates.Lo),
+				Current.Key
+			);
+			// The slot takes the next key, or the last slot takes its place
+			if( Next < Count )
+			{
+				Current = { Keys[Next], Top, Next };
+				++Next;
+				PrefetchNext(Top);
+				++i;
+			}
+			else
+			{
+				Current = Slots[--Active];
+			}
+		}
+	}
+}
@@ -0,0 +1,521 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <system_error>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <time.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "FibBatch.hpp"
+
+// Local F(n) query server over a Unix-domain stream socket
+//
+// Queries from every connection are coalesced into one batch until either
+// at least MaxBatch queries are pending or the oldest pending query has waited for
+// Deadline. The batch is evaluated at once and each connection receives all
+// of its answers from that batch in a single write, in the order it asked.
+//
+// The server never blocks on one connection: answers the socket won't take
+// yet are queued and sent as it drains, and a connection with too much
+// queued stops being read until its client catches up. A client that shuts
+// down its sending side still gets every answer it asked for before the
+// connection is closed.
+
+// Bytes of unsent answers after which a connection is no longer read
+constexpr std::size_t FibServerMaxBacklog = 256 * 1024;
+
+// A Modulus of 0 means mod 2^64
+struct FibQuery
+{
+	std::uint64_t Id;
+	std::uint64_t n;
+	std::uint64_t Modulus;
+};
+
+struct FibAnswer
+{
+	std::uint64_t Id;
+	std::uint64_t Value;
+};
+
+struct FibServerStats
+{
+	std::uint64_t Queries = 0;
+	std::uint64_t Batches = 0;
+	std::uint64_t Writes  = 0;
+};
+
+namespace FibSocket
+{
+[[noreturn]] inline void ThrowErrno( const char* What )
+{
+	throw std::system_error(errno, std::generic_category(), What);
+}
+
+inline sockaddr_un Address( const std::string& Path )
+{
+	sockaddr_un Addr;
+	std::memset(&Addr, 0, sizeof(Addr));
+	Addr.sun_family = AF_UNIX;
+	std::strncpy(Addr.sun_path, Path.c_str(), sizeof(Addr.sun_path) - 1);
+	return Addr;
+}
+
+// Writes all of Size bytes, waiting out a full socket buffer if needed
+// For clients, the server itself never waits on a socket
+inline bool WriteAll( int Socket, const void* Data, std::size_t Size )
+{
+	const char* Bytes = static_cast<const char*>(Data);
+	while( Size )
+	{
+		const ssize_t Written = ::write(Socket, Bytes, Size);
+		if( Written < 0 )
+		{
+			if( errno == EAGAIN || errno == EWOULDBLOCK )
+			{
+				pollfd Wait = { Socket, POLLOUT, 0 };
+				::poll(&Wait, 1, -1);
+				continue;
+			}
+			if( errno == EINTR )
+			{
+				continue;
+			}
+			return false;
+		}
+		Bytes += Written;
+		Size -= static_cast<std::size_t>(Written);
+	}
+	return true;
+}
+
+// Clears Path for a new listener, if it is left over from one that is gone
+// Anything else there, including a socket that still accepts connections,
+// is left alone and throws
+inline void RemoveStale( const std::string& Path )
+{
+	struct stat Info;
+	if( ::lstat(Path.c_str(), &Info) < 0 )
+	{
+		if( errno == ENOENT )
+		{
+			return;
+		}
+		ThrowErrno("stat");
+	}
+	if( !S_ISSOCK(Info.st_mode) )
+	{
+		throw std::system_error(EEXIST, std::generic_category(), Path + " is not a socket");
+	}
+	const int Probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if( Probe < 0 )
+	{
+		ThrowErrno("socket");
+	}
+	const sockaddr_un Addr = Address(Path);
+	const int Connected = ::connect(Probe, reinterpret_cast<const sockaddr*>(&Addr), sizeof(Addr));
+	const int Error = errno;
+	::close(Probe);
+	if( Connected == 0 )
+	{
+		throw std::system_error(EADDRINUSE, std::generic_category(), Path + " is being served");
+	}
+	if( Error != ECONNREFUSED )
+	{
+		throw std::system_error(Error, std::generic_category(), "connect");
+	}
+	if( ::unlink(Path.c_str()) < 0 && errno != ENOENT )
+	{
+		ThrowErrno("unlink");
+	}
+}
+
+inline int Connect( const std::string& Path )
+{
+	const int Socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if( Socket < 0 )
+	{
+		ThrowErrno("socket");
+	}
+	const sockaddr_un Addr = Address(Path);
+	if( ::connect(Socket, reinterpret_cast<const sockaddr*>(&Addr), sizeof(Addr)) < 0 )
+	{
+		::close(Socket);
+		ThrowErrno("connect");
+	}
+	return Socket;
+}
+}
+
+class FibServer
+{
+public:
+	using ClockT = std::chrono::steady_clock;
+
+	FibServer(
+		const std::string& Path, std::size_t MaxBatch, std::chrono::microseconds Deadline
+	)
+		: Path(Path), MaxBatch(std::max<std::size_t>(MaxBatch, 1)), Deadline(Deadline)
+	{
+		FibSocket::RemoveStale(Path);
+		Listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if( Listener < 0 )
+		{
+			FibSocket::ThrowErrno("socket");
+		}
+		const sockaddr_un Addr = FibSocket::Address(Path);
+		if( ::bind(Listener, reinterpret_cast<const sockaddr*>(&Addr), sizeof(Addr)) < 0 )
+		{
+			const int Error = errno;
+			::close(Listener);
+			throw std::system_error(Error, std::generic_category(), "bind");
+		}
+		if( ::listen(Listener, 128) < 0 )
+		{
+			const int Error = errno;
+			::close(Listener);
+			::unlink(Path.c_str());
+			throw std::system_error(Error, std::generic_category(), "listen");
+		}
+		// Remembered so the destructor only ever removes this socket
+		struct stat Info;
+		if( ::lstat(Path.c_str(), &Info) == 0 )
+		{
+			BoundDevice = Info.st_dev;
+			BoundInode = Info.st_ino;
+		}
+		::fcntl(Listener, F_SETFL, ::fcntl(Listener, F_GETFL) | O_NONBLOCK);
+	}
+
+	~FibServer()
+	{
+		for( const Client& Cur : Clients )
+		{
+			::close(Cur.Socket);
+		}
+		::close(Listener);
+		// Unless something else has been put in its place since
+		struct stat Info;
+		if(
+			::lstat(Path.c_str(), &Info) == 0
+			&& Info.st_dev == BoundDevice && Info.st_ino == BoundInode
+		)
+		{
+			::unlink(Path.c_str());
+		}
+	}
+
+	FibServer( const FibServer& ) = delete;
+	FibServer& operator=( const FibServer& ) = delete;
+
+	// Serves until Running is cleared
+	void Run( const std::atomic<bool>& Running )
+	{
+		std::vector<pollfd> Polls;
+		while( Running.load(std::memory_order_relaxed) )
+		{
+			// Closed clients are only waiting on their pending queries to be
+			// removed, and would report POLLHUP on every poll. Clients done
+			// sending are only polled while they have answers queued
+			Polls.clear();
+			Polled.clear();
+			Polls.push_back({ Listener, POLLIN, 0 });
+			for( std::size_t i = 0; i < Clients.size(); ++i )
+			{
+				const Client& Cur = Clients[i];
+				const std::size_t Queued = Backlog(Cur);
+				if( Cur.Closed || (Cur.ReadClosed && !Queued) )
+				{
+					continue;
+				}
+				const bool Reading = !Cur.ReadClosed && Queued < FibServerMaxBacklog;
+				const short Events = static_cast<short>((Reading ? POLLIN : 0) | (Queued ? POLLOUT : 0));
+				Polls.push_back({ Cur.Socket, Events, 0 });
+				Polled.push_back(i);
+			}
+
+			// Sleep no longer than the deadline of the oldest pending query
+			timespec Timeout = { 0, 50 * 1000 * 1000 };
+			if( !Pending.empty() )
+			{
+				const auto Remaining = std::max<std::chrono::nanoseconds>(
+					OldestArrival + Deadline - ClockT::now(), std::chrono::nanoseconds(0)
+				);
+				Timeout.tv_sec = static_cast<time_t>(Remaining.count() / 1000000000);
+				Timeout.tv_nsec = static_cast<long>(Remaining.count() % 1000000000);
+			}
+			::ppoll(Polls.data(), Polls.size(), &Timeout, nullptr);
+
+			// New clients are only appended after this loop, so Polls[i + 1]
+			// lines up with Clients[Polled[i]]
+			for( std::size_t i = 0; i < Polled.size(); ++i )
+			{
+				const short Events = Polls[i + 1].revents;
+				// A hung up client fails the send and is closed, even while
+				// it is not being read
+				if( Events & (POLLOUT | POLLHUP | POLLERR) )
+				{
+					Send(Clients[Polled[i]]);
+				}
+				if( Events & (POLLIN | POLLHUP | POLLERR) )
+				{
+					Receive(Polled[i]);
+				}
+			}
+			if( Polls[0].revents & POLLIN )
+			{
+				Accept();
+			}
+			Flush(false);
+			RemoveClosed();
+		}
+		Flush(true);
+	}
+
+	const FibServerStats& Stats() const
+	{
+		return Statistics;
+	}
+
+private:
+	struct Client
+	{
+		int Socket;
+		// Gone, or failed, nothing more is sent
+		bool Closed;
+		// Done sending queries, closed once all of them are answered
+		bool ReadClosed;
+		// Bytes of a partially received query
+		std::size_t Partial;
+		alignas(FibQuery) char Buffer[sizeof(FibQuery) * 64];
+		// Answers the socket has not taken yet, from Sent on
+		std::vector<char> Outgoing;
+		std::size_t Sent;
+	};
+
+	struct PendingQuery
+	{
+		std::size_t ClientIndex;
+		FibQuery Query;
+	};
+
+	void Accept()
+	{
+		int Socket;
+		while( (Socket = ::accept(Listener, nullptr, nullptr)) >= 0 )
+		{
+			::fcntl(Socket, F_SETFL, ::fcntl(Socket, F_GETFL) | O_NONBLOCK);
+			Clients.emplace_back();
+			Client& NewClient = Clients.back();
+			NewClient.Socket = Socket;
+			NewClient.Closed = false;
+			NewClient.ReadClosed = false;
+			NewClient.Partial = 0;
+			NewClient.Sent = 0;
+		}
+	}
+
+	void Receive( std::size_t Index )
+	{
+		Client& Cur = Clients[Index];
+		while( !Cur.Closed && !Cur.ReadClosed && Backlog(Cur) < FibServerMaxBacklog )
+		{
+			const ssize_t Read = ::read(
+				Cur.Socket, Cur.Buffer + Cur.Partial, sizeof(Cur.Buffer) - Cur.Partial
+			);
+			if( Read == 0 )
+			{
+				Cur.ReadClosed = true;
+				return;
+			}
+			if( Read < 0 )
+			{
+				if( errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR )
+				{
+					Cur.Closed = true;
+				}
+				return;
+			}
+			const std::size_t Available = Cur.Partial + static_cast<std::size_t>(Read);
+			const std::size_t Whole = Available / sizeof(FibQuery);
+			if( Whole && Pending.empty() )
+			{
+				OldestArrival = ClockT::now();
+			}
+			for( std::size_t i = 0; i < Whole; ++i )
+			{
+				PendingQuery NewQuery;
+				NewQuery.ClientIndex = Index;
+				std::memcpy(&NewQuery.Query, Cur.Buffer + i * sizeof(FibQuery), sizeof(FibQuery));
+				Pending.push_back(NewQuery);
+			}
+			Cur.Partial = Available - Whole * sizeof(FibQuery);
+			std::memmove(Cur.Buffer, Cur.Buffer + Whole * sizeof(FibQuery), Cur.Partial);
+			// Keep draining, the deadline check happens once per poll
+			if( Pending.size() >= MaxBatch )
+			{
+				Flush(false);
+			}
+		}
+	}
+
+	// Evaluates and answers the pending batch once it is due
+	void Flush( bool Force )
+	{
+		if( Pending.empty() )
+		{
+			return;
+		}
+		if(
+			!Force && Pending.size() < MaxBatch
+			&& ClockT::now() < OldestArrival + Deadline
+		)
+		{
+			return;
+		}
+
+		// Everything mod 2^64 goes through the vectorized path, the rest is
+		// evaluated one at a time
+		const std::size_t Count = Pending.size();
+		Indices.clear();
+		Results.resize(Count);
+		for( const PendingQuery& Cur : Pending )
+		{
+			if( Cur.Query.Modulus == 0 )
+			{
+				Indices.push_back(Cur.Query.n);
+			}
+		}
+		BatchResults.resize(Indices.size());
+		FibBatch64(Indices.data(), BatchResults.data(), Indices.size());
+		for( std::size_t i = 0, j = 0; i < Count; ++i )
+		{
+			const FibQuery& Query = Pending[i].Query;
+			Results[i] = Query.Modulus == 0 ? BatchResults[j++] : FibMod(Query.n, Query.Modulus);
+		}
+
+		// Gather each client's answers, in arrival order, into one write
+		Order.resize(Count);
+		for( std::size_t i = 0; i < Count; ++i )
+		{
+			Order[i] = i;
+		}
+		std::stable_sort(
+			Order.begin(), Order.end(),
+			[this]( std::size_t A, std::size_t B )
+			{
+				return Pending[A].ClientIndex < Pending[B].ClientIndex;
+			}
+		);
+		for( std::size_t Begin = 0; Begin < Count; )
+		{
+			const std::size_t ClientIndex = Pending[Order[Begin]].ClientIndex;
+			Answers.clear();
+			std::size_t End = Begin;
+			for( ; End < Count && Pending[Order[End]].ClientIndex == ClientIndex; ++End )
+			{
+				Answers.push_back({ Pending[Order[End]].Query.Id, Results[Order[End]] });
+			}
+			Client& Cur = Clients[ClientIndex];
+			if( !Cur.Closed )
+			{
+				const char* Bytes = reinterpret_cast<const char*>(Answers.data());
+				Cur.Outgoing.insert(Cur.Outgoing.end(), Bytes, Bytes + Answers.size() * sizeof(FibAnswer));
+				Send(Cur);
+				++Statistics.Writes;
+			}
+			Begin = End;
+		}
+
+		Statistics.Queries += Count;
+		++Statistics.Batches;
+		Pending.clear();
+	}
+
+	static std::size_t Backlog( const Client& Cur )
+	{
+		return Cur.Outgoing.size() - Cur.Sent;
+	}
+
+	// Sends as much of the backlog as the socket takes without waiting
+	void Send( Client& Cur )
+	{
+		while( !Cur.Closed && Backlog(Cur) )
+		{
+			const ssize_t Written = ::send(
+				Cur.Socket, Cur.Outgoing.data() + Cur.Sent, Backlog(Cur), MSG_NOSIGNAL
+			);
+			if( Written < 0 )
+			{
+				if( errno == EINTR )
+				{
+					continue;
+				}
+				if( errno != EAGAIN && errno != EWOULDBLOCK )
+				{
+					Cur.Closed = true;
+				}
+				break;
+			}
+			Cur.Sent += static_cast<std::size_t>(Written);
+		}
+		// Drop what has been sent once it outweighs what is left
+		if( Cur.Sent > Backlog(Cur) )
+		{
+			Cur.Outgoing.erase(Cur.Outgoing.begin(), Cur.Outgoing.begin() + static_cast<std::ptrdiff_t>(Cur.Sent));
+			Cur.Sent = 0;
+		}
+	}
+
+	// Only called with no queries pending, so client indices stay valid, and
+	// every query of a client done sending has its answer queued
+	void RemoveClosed()
+	{
+		if( !Pending.empty() )
+		{
+			return;
+		}
+		for( std::size_t i = Clients.size(); i-- > 0; )
+		{
+			if( Clients[i].Closed || (Clients[i].ReadClosed && !Backlog(Clients[i])) )
+			{
+				::close(Clients[i].Socket);
+				Clients.erase(Clients.begin() + i);
+			}
+		}
+	}
+
+	std::string Path;
+	std::size_t MaxBatch;
+	std::chrono::microseconds Deadline;
+	int Listener;
+	dev_t BoundDevice = 0;
+	ino_t BoundInode = 0;
+
+	std::vector<Client> Clients;
+	// Clients in the poll set, in order
+	std::vector<std::size_t> Polled;
+	std::vector<PendingQuery> Pending;
+	ClockT::time_point OldestArrival;
+
+	// Scratch space, kept around between batches
+	std::vector<std::uint64_t> Indices;
+	std::vector<std::uint64_t> BatchResults;
+	std::vector<std::uint64_t> Results;
+	std::vector<std::size_t> Order;
+	std::vector<FibAnswer> Answers;
+
+	FibServerStats Statistics;
+};
@@ -0,0 +1,143 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+
+#include <immintrin.h>
+
+#if !defined(__AVX512F__) && !(defined(__AVX2__) && defined(__FMA__))
+#error "FibSimd.hpp needs AVX-512F, or AVX2 with FMA"
+#endif
+
+// Thin wrappers over a full register of 64-bit lanes, so that the same
+// floating-point kernels build for AVX-512 or for AVX2
+//
+// Words holds unsigned 64-bit integers, Doubles holds doubles, and Mask is
+// whatever comparisons produce on the target: a k-register for AVX-512 and
+// an all-ones-or-zero vector for AVX2.
+
+namespace FibSimd
+{
+// 2^52, integers below it sit in the low mantissa bits of 2^52 + x
+constexpr double Magic = 4503599627370496.0;
+
+#if defined(__AVX512F__)
+constexpr std::size_t Width = 8;
+using Words   = __m512i;
+using Doubles = __m512d;
+using Mask    = __mmask8;
+
+// Some operations use their masked forms with every lane set, the unmasked
+// ones trip -Wmaybe-uninitialized on GCC 12
+
+inline Words   LoadWords( const std::uint64_t* N ) { return _mm512_loadu_si512(N); }
+inline void    Store( double* Out, Doubles A ) { _mm512_storeu_pd(Out, A); }
+inline void    Store( std::uint64_t* Out, Words A ) { _mm512_storeu_si512(Out, A); }
+inline Doubles Set1( double A ) { return _mm512_set1_pd(A); }
+inline Words   Splat( std::uint64_t A ) { return _mm512_set1_epi64(static_cast<std::int64_t>(A)); }
+// 0, 1, ..., Width - 1, lowest lane first
+inline Words   Lanes() { return _mm512_set_epi64(7, 6, 5, 4, 3, 2, 1, 0); }
+inline Words   AddWords( Words A, Words B ) { return _mm512_add_epi64(A, B); }
+inline Words   SubWords( Words A, Words B ) { return _mm512_sub_epi64(A, B); }
+inline Doubles Add( Doubles A, Doubles B ) { return _mm512_add_pd(A, B); }
+inline Doubles Sub( Doubles A, Doubles B ) { return _mm512_sub_pd(A, B); }
+inline Doubles Mul( Doubles A, Doubles B ) { return _mm512_mul_pd(A, B); }
+inline Doubles Div( Doubles A, Doubles B ) { return _mm512_div_pd(A, B); }
+inline Doubles Max( Doubles A, Doubles B ) { return _mm512_mask_max_pd(A, 0xFF, A, B); }
+inline Doubles Sqrt( Doubles A ) { return _mm512_mask_sqrt_pd(A, 0xFF, A); }
+// A * B + C
+inline Doubles Fma( Doubles A, Doubles B, Doubles C ) { return _mm512_fmadd_pd(A, B, C); }
+inline Doubles Floor( Doubles A ) { return _mm512_mask_roundscale_pd(A, 0xFF, A, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC); }
+inline Doubles Round( Doubles A ) { return _mm512_mask_roundscale_pd(A, 0xFF, A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline Doubles AsDoubles( Words A ) { return _mm512_castsi512_pd(A); }
+inline Words   AsWords( Doubles A ) { return _mm512_castpd_si512(A); }
+inline Words   Or( Words A, Words B ) { return _mm512_or_si512(A, B); }
+inline Words   Xor( Words A, Words B ) { return _mm512_xor_si512(A, B); }
+inline Words   And( Words A, Words B ) { return _mm512_and_si512(A, B); }
+template< int Shift >
+inline Words   Shl( Words A ) { return _mm512_mask_slli_epi64(A, 0xFF, A, Shift); }
+template< int Shift >
+inline Words   Shr( Words A ) { return _mm512_mask_srli_epi64(A, 0xFF, A, Shift); }
+inline Mask    Equal( Doubles A, Doubles B ) { return _mm512_cmp_pd_mask(A, B, _CMP_EQ_OQ); }
+inline Mask    GreaterEqual( Doubles A, Doubles B ) { return _mm512_cmp_pd_mask(A, B, _CMP_GE_OQ); }
+inline Mask    Less( Doubles A, Doubles B ) { return _mm512_cmp_pd_mask(A, B, _CMP_LT_OQ); }
+// Low < A < High
+inline Mask    Inside( Doubles A, double Low, double High )
+{
+	return _mm512_cmp_pd_mask(A, Set1(Low), _CMP_GT_OQ) & _mm512_cmp_pd_mask(A, Set1(High), _CMP_LT_OQ);
+}
+inline Mask    Either( Mask A, Mask B ) { return A | B; }
+inline Mask    IsZero( Words A ) { return _mm512_testn_epi64_mask(A, A); }
+// Unsigned
+inline Mask    Above( Words A, std::uint64_t B ) { return _mm512_cmpgt_epu64_mask(A, Splat(B)); }
+inline Mask    AtLeast( Words A, Words B ) { return _mm512_cmpge_epu64_mask(A, B); }
+inline Doubles Select( Mask M, Doubles IfTrue, Doubles IfFalse ) { return _mm512_mask_blend_pd(M, IfFalse, IfTrue); }
+inline Words   Select( Mask M, Words IfTrue, Words IfFalse ) { return _mm512_mask_blend_epi64(M, IfFalse, IfTrue); }
+#else
+constexpr std::size_t Width = 4;
+using Words   = __m256i;
+using Doubles = __m256d;
+using Mask    = __m256d;
+
+inline Words   LoadWords( const std::uint64_t* N ) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(N)); }
+inline void    Store( double* Out, Doubles A ) { _mm256_storeu_pd(Out, A); }
+inline void    Store( std::uint64_t* Out, Words A ) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(Out), A); }
+inline Doubles Set1( double A ) { return _mm256_set1_pd(A); }
+inline Words   Splat( std::uint64_t A ) { return _mm256_set1_epi64x(static_cast<std::int64_t>(A)); }
+inline Words   Lanes() { return _mm256_set_epi64x(3, 2, 1, 0); }
+inline Words   AddWords( Words A, Words B ) { return _mm256_add_epi64(A, B); }
+inline Words   SubWords( Words A, Words B ) { return _mm256_sub_epi64(A, B); }
+inline Doubles Add( Doubles A, Doubles B ) { return _mm256_add_pd(A, B); }
+inline Doubles Sub( Doubles A, Doubles B ) { return _mm256_sub_pd(A, B); }
+inline Doubles Mul( Doubles A, Doubles B ) { return _mm256_mul_pd(A, B); }
+inline Doubles Div( Doubles A, Doubles B ) { return _mm256_div_pd(A, B); }
+inline Doubles Max( Doubles A, Doubles B ) { return _mm256_max_pd(A, B); }
+inline Doubles Sqrt( Doubles A ) { return _mm256_sqrt_pd(A); }
+// A * B + C
+inline Doubles Fma( Doubles A, Doubles B, Doubles C ) { return _mm256_fmadd_pd(A, B, C); }
+inline Doubles Floor( Doubles A ) { return _mm256_floor_pd(A); }
+inline Doubles Round( Doubles A ) { return _mm256_round_pd(A, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); }
+inline Doubles AsDoubles( Words A ) { return _mm256_castsi256_pd(A); }
+inline Words   AsWords( Doubles A ) { return _mm256_castpd_si256(A); }
+inline Words   Or( Words A, Words B ) { return _mm256_or_si256(A, B); }
+inline Words   Xor( Words A, Words B ) { return _mm256_xor_si256(A, B); }
+inline Words   And( Words A, Words B ) { return _mm256_and_si256(A, B); }
+template< int Shift >
+inline Words   Shl( Words A ) { return _mm256_slli_epi64(A, Shift); }
+template< int Shift >
+inline Words   Shr( Words A ) { return _mm256_srli_epi64(A, Shift); }
+inline Mask    Equal( Doubles A, Doubles B ) { return _mm256_cmp_pd(A, B, _CMP_EQ_OQ); }
+inline Mask    GreaterEqual( Doubles A, Doubles B ) { return _mm256_cmp_pd(A, B, _CMP_GE_OQ); }
+inline Mask    Less( Doubles A, Doubles B ) { return _mm256_cmp_pd(A, B, _CMP_LT_OQ); }
+inline Mask    Inside( Doubles A, double Low, double High )
+{
+	return _mm256_and_pd(_mm256_cmp_pd(A, Set1(Low), _CMP_GT_OQ), _mm256_cmp_pd(A, Set1(High), _CMP_LT_OQ));
+}
+inline Mask    Either( Mask A, Mask B ) { return _mm256_or_pd(A, B); }
+inline Mask    IsZero( Words A ) { return AsDoubles(_mm256_cmpeq_epi64(A, _mm256_setzero_si256())); }
+// Unsigned, AVX2 only compares signed 64-bit lanes
+inline Mask    Above( Words A, std::uint64_t B )
+{
+	const Words Flip = Splat(1ULL << 63);
+	return AsDoubles(_mm256_cmpgt_epi64(Xor(A, Flip), Xor(Splat(B), Flip)));
+}
+inline Mask    AtLeast( Words A, Words B )
+{
+	const Words Flip = Splat(1ULL << 63);
+	return AsDoubles(Xor(_mm256_cmpgt_epi64(Xor(B, Flip), Xor(A, Flip)), Splat(~0ULL)));
+}
+inline Doubles Select( Mask M, Doubles IfTrue, Doubles IfFalse ) { return _mm256_blendv_pd(IfFalse, IfTrue, M); }
+inline Words   Select( Mask M, Words IfTrue, Words IfFalse ) { return AsWords(_mm256_blendv_pd(AsDoubles(IfFalse), AsDoubles(IfTrue), M)); }
+#endif
+
+// n < 2^52 as a double
+inline Doubles ToDoubles( Words n )
+{
+	return Sub(AsDoubles(Or(n, AsWords(Set1(Magic)))), Set1(Magic));
+}
+
+// Integral k in [0, 2^52) as an integer
+inline Words ToWords( Doubles k )
+{
+	return And(AsWords(Add(k, Set1(Magic))), Splat((1ULL << 52) - 1));
+}
+}
@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <utility>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "FibKernels.hpp"
+
+// Evaluates F(n)(mod 2^64) over a sorted batch of indices in a single pass
+//
+// The walk carries the pair F(p), F(p + 1) from one index to the next:
+// - Runs of closely spaced indices are served from a tile of consecutive
+//   terms, generated with the SIMD kernel straight from the carried pair
+// - Isolated indices jump across the gap with precomputed F(2^j), F(2^j + 1)
+//   pairs, costing four multiplies per set bit of the gap rather than a full
+//   fast doubling of n
+
+// Terms per tile
+constexpr std::size_t FibSortedTileTerms = 256;
+
+// Runs with an average gap at or below this are generated as a tile, sparser
+// ones are jumped through. Forced to one or the other, tiles and jumps break
+// even at an average gap of about 12 to 16 on uniform random gaps. Somewhat
+// sparser batches still hold close pairs that get a tile, so around an
+// average gap of 32 the choice trails pure jumps by 10 to 15%: pass 0 for
+// batches known to be sparse
+constexpr std::uint64_t FibSortedDenseGap = 12;
+
+// F(2^j), F(2^j + 1) for every bit j
+inline const std::array<std::pair<std::uint64_t, std::uint64_t>, 64>& FibJumpTable()
+{
+	static const auto Table = []()
+	{
+		std::array<std::pair<std::uint64_t, std::uint64_t>, 64> Pow2;
+		Pow2[0] = std::make_pair(1, 1);
+		for( std::size_t j = 1; j < 64; ++j )
+		{
+			// F(2k) = F(k) * [ 2 * F(k+1) - F(k) ], F(2k+1) = F(k)^2 + F(k+1)^2
+			const std::uint64_t a = Pow2[j - 1].first;
+			const std::uint64_t b = Pow2[j - 1].second;
+			Pow2[j] = std::make_pair(a * (2 * b - a), a * a + b * b);
+		}
+		return Pow2;
+	}();
+	return Table;
+}
+
+// F(p), F(p + 1) into F(p + Gap), F(p + Gap + 1)
+// F(p + m)     = F(p + 1) * F(m)     + F(p) * F(m - 1)
+// F(p + m + 1) = F(p + 1) * F(m + 1) + F(p) * F(m)
+inline void FibJump( std::uint64_t& a, std::uint64_t& b, std::uint64_t Gap )
+{
+	const auto& Table = FibJumpTable();
+	while( Gap )
+	{
+		#ifdef _MSC_VER
+		const std::size_t j = _tzcnt_u64(Gap);
+		#else
+		const std::size_t j = __builtin_ctzll(Gap);
+		#endif
+		const std::uint64_t Fm  = Table[j].first;
+		const std::uint64_t Fm1 = Table[j].second;
+		const std::uint64_t NextA = b * Fm + a * (Fm1 - Fm);
+		const std::uint64_t NextB = b * Fm1 + a * Fm;
+		a = NextA;
+		b = NextB;
+		Gap &= Gap - 1;
+	}
+}
+
+// Out[i] = F(N[i]) mod 2^64, N must be sorted in ascending order
+// A DenseGap of 0 never generates tiles and always jumps, and any above
+// FibSortedTileTerms acts like FibSortedTileTerms
+inline void FibSortedBatch(
+	const std::uint64_t* N, std::uint64_t* Out, std::size_t Count,
+	std::uint64_t DenseGap = FibSortedDenseGap
+)
+{
+	// One extra vector so the term after the tile is always there too
+	alignas(32) std::uint64_t Tile[FibSortedTileTerms + 4];
+	// No run spans more than a tile anyway, and this keeps the run length
+	// times DenseGap from overflowing
+	DenseGap = std::min<std::uint64_t>(DenseGap, FibSortedTileTerms);
+
+	std::uint64_t p = 0;
+	std::uint64_t a = 0; // F(p)
+	std::uint64_t b = 1; // F(p + 1)
+	for( std::size_t i = 0; i < Count; )
+	{
+		FibJump(a, b, N[i] - p);
+		p = N[i];
+
+		// Run of indices from here that fit within one tile, for as long as
+		// they stay dense enough on average
+		std::size_t j = i + 1;
+		while(
+			j < Count && N[j] - p < FibSortedTileTerms
+			&& N[j] - p <= (j - i) * DenseGap
+		)
+		{
+			++j;
+		}
+		if( j - i < 2 )
+		{
+			Out[i++] = a;
+			continue;
+		}
+		const std::uint64_t Span = N[j - 1] - p + 1;
+
+		__m256i FibState = FibState4x64(a, b);
+		for( std::size_t k = 0; k <= Span; k += 4 )
+		{
+			_mm256_store_si256(reinterpret_cast<__m256i*>(Tile + k), FibState);
+			FibState = FibNext4x64(FibState);
+		}
+		for( ; i < j; ++i )
+		{
+			Out[i] = Tile[N[i] - p];
+		}
+		p = N[j - 1];
+		a = Tile[Span - 1];
+		b = Tile[Span];
+	}
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "FibKernels.hpp"
+#include "FibSorted.hpp"
+
+// Samples every Stride-th term F(Start), F(Start + Stride), ...(mod 2^64)
+// without generating the terms in between
+//
+// Every lane carries a pair F(n), F(n + 1) and moves it M terms ahead with
+// the precomputed F(M - 1), F(M), F(M + 1):
+//   F(n + M)     = F(n + 1) * F(M)     + F(n) * F(M - 1)
+//   F(n + M + 1) = F(n + 1) * F(M + 1) + F(n) * F(M)
+// Lanes hold consecutive samples, so M is the stride times the number of
+// samples in flight and a sample costs four multiplies whatever the stride.
+
+// Samples in flight, as four vectors of four lanes to hide the latency of
+// the multiplies
+constexpr std::size_t FibStridedGroup = 16;
+
+// Out[i] = F(Start + i * Stride) mod 2^64, for i = 0..Count-1
+inline void FibStrided64(
+	std::uint64_t Start, std::uint64_t Stride, std::uint64_t* Out, std::size_t Count
+)
+{
+	alignas(32) std::uint64_t Term[FibStridedGroup];
+	alignas(32) std::uint64_t Next[FibStridedGroup];
+	{
+		const auto Pair = FibPair<std::uint64_t>(Start);
+		std::uint64_t a = Pair.first, b = Pair.second;
+		for( std::size_t i = 0; i < FibStridedGroup; ++i )
+		{
+			Term[i] = a;
+			Next[i] = b;
+			FibJump(a, b, Stride);
+		}
+	}
+
+	// F(M), F(M + 1) for M = Stride * FibStridedGroup, doubling F(Stride)
+	// rather than multiplying the indices so that M may exceed 2^64
+	static_assert(
+		(FibStridedGroup & (FibStridedGroup - 1)) == 0, "The group must be a power of two"
+	);
+	std::uint64_t Fm = 0, Fm1 = 1;
+	FibJump(Fm, Fm1, Stride);
+	for( std::size_t Span = 1; Span < FibStridedGroup; Span *= 2 )
+	{
+		// F(2k) = F(k) * [ 2 * F(k+1) - F(k) ], F(2k+1) = F(k)^2 + F(k+1)^2
+		const std::uint64_t Doubled = Fm * (2 * Fm1 - Fm);
+		Fm1 = Fm * Fm + Fm1 * Fm1;
+		Fm = Doubled;
+	}
+	const __m256i JumpPrev = _mm256_set1_epi64x(static_cast<long long>(Fm1 - Fm));
+	const __m256i Jump     = _mm256_set1_epi64x(static_cast<long long>(Fm));
+	const __m256i JumpNext = _mm256_set1_epi64x(static_cast<long long>(Fm1));
+
+	__m256i A0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Term + 0));
+	__m256i A1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Term + 4));
+	__m256i A2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Term + 8));
+	__m256i A3 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Term + 12));
+	__m256i B0 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Next + 0));
+	__m256i B1 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Next + 4));
+	__m256i B2 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Next + 8));
+	__m256i B3 = _mm256_load_si256(reinterpret_cast<const __m256i*>(Next + 12));
+
+	const auto Advance = [&]( __m256i& A, __m256i& B )
+	{
+		const __m256i NextA = _mm256_add_epi64(MulLo64x4(B, Jump), MulLo64x4(A, JumpPrev));
+		B = _mm256_add_epi64(MulLo64x4(B, JumpNext), MulLo64x4(A, Jump));
+		A = NextA;
+	};
+
+	std::size_t i = 0;
+	for( ; i + FibStridedGroup <= Count; i += FibStridedGroup )
+	{
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + i + 0), A0);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + i + 4), A1);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + i + 8), A2);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(Out + i + 12), A3);
+		Advance(A0, B0);
+		Advance(A1, B1);
+		Advance(A2, B2);
+		Advance(A3, B3);
+	}
+	if( i < Count )
+	{
+		_mm256_store_si256(reinterpret_cast<__m256i*>(Term + 0), A0);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(Term + 4), A1);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(Term + 8), A2);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(Term + 12), A3);
+		std::copy(Term, Term + (Count - i), Out + i);
+	}
+}
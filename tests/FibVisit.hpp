@@ -0,0 +1,103 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "FibKernels.hpp"
+
+// Fused generate-and-consume over F(Start..Start + Count - 1)(mod 2^64)
+//
+// Rather than writing the terms out and reading them back, the generator
+// hands them to a visitor as they are produced, either:
+// - FibVisit: one register of four terms at a time, straight out of the
+//   SIMD kernel, never touching memory at all
+// - FibVisitTiles: one small tile at a time, generated into a buffer that
+//   stays in L1 for consumers that want a plain array
+// Either visitor is called as Visit(Terms, Index, Count) with Count terms
+// from F(Index) on. It is a template parameter so it inlines into the
+// generator loop, and returns false to stop early. Both return the index
+// just past the last term handed over, Start + Count when the visitor never
+// stopped.
+
+// Terms per tile, 4 KiB, leaving most of L1 to the consumer
+constexpr std::size_t FibVisitTileTerms = 512;
+
+// Lanes [0, Lanes) of a register set, the valid terms of a short last one
+inline __m256i FibVisitLanes( std::size_t Lanes )
+{
+	return _mm256_cmpgt_epi64(
+		_mm256_set1_epi64x(static_cast<long long>(Lanes)), _mm256_set_epi64x(3, 2, 1, 0)
+	);
+}
+
+// Terms with every lane from Lanes on zeroed
+inline __m256i FibVisitMasked( __m256i Terms, std::size_t Lanes )
+{
+	return Lanes == 4 ? Terms : _mm256_and_si256(Terms, FibVisitLanes(Lanes));
+}
+
+// Sum of the four lanes, mod 2^64
+inline std::uint64_t FibVisitSum( __m256i Terms )
+{
+	alignas(32) std::uint64_t Lanes[4];
+	_mm256_store_si256(reinterpret_cast<__m256i*>(Lanes), Terms);
+	return Lanes[0] + Lanes[1] + Lanes[2] + Lanes[3];
+}
+
+// Visit(__m256i Terms, std::uint64_t Index, std::size_t Count) -> bool
+// Terms holds F(Index + 0..3), lowest lane first, of which the first Count
+// are in range. Count is 4 but for the last call, whose extra lanes hold the
+// terms that follow
+template< typename VisitT >
+std::uint64_t FibVisit( std::uint64_t Start, std::uint64_t Count, VisitT&& Visit )
+{
+	__m256i FibState = FibState4x64(Start);
+	std::uint64_t Index = Start;
+	const std::uint64_t Stop = Start + Count;
+	for( ; Stop - Index >= 4; Index += 4 )
+	{
+		if( !Visit(FibState, Index, std::size_t(4)) )
+		{
+			return Index + 4;
+		}
+		FibState = FibNext4x64(FibState);
+	}
+	if( Index != Stop )
+	{
+		Visit(FibState, Index, static_cast<std::size_t>(Stop - Index));
+	}
+	return Stop;
+}
+
+// Visit(const std::uint64_t* Terms, std::uint64_t Index, std::size_t Count) -> bool
+// Terms[0..Count) is F(Index + 0..Count-1), Count is FibVisitTileTerms but
+// for the last tile. Terms is only valid during the call
+template< typename VisitT >
+std::uint64_t FibVisitTiles( std::uint64_t Start, std::uint64_t Count, VisitT&& Visit )
+{
+	alignas(64) std::uint64_t Tile[FibVisitTileTerms];
+	__m256i FibState = FibState4x64(Start);
+	std::uint64_t Index = Start;
+	const std::uint64_t Stop = Start + Count;
+	while( Index != Stop )
+	{
+		const std::size_t Size = static_cast<std::size_t>(
+			std::min<std::uint64_t>(FibVisitTileTerms, Stop - Index)
+		);
+		// Whole registers, a short last tile just has a few terms to spare
+		for( std::size_t i = 0; i < Size; i += 4 )
+		{
+			_mm256_store_si256(reinterpret_cast<__m256i*>(Tile + i), FibState);
+			FibState = FibNext4x64(FibState);
+		}
+		const bool More = Visit(static_cast<const std::uint64_t*>(Tile), Index, Size);
+		Index += Size;
+		if( !More )
+		{
+			break;
+		}
+	}
+	return Index;
+}
@@ -0,0 +1,286 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+
+#include <immintrin.h>
+
+#include "FibKernels.hpp"
+#include "RingBuffer.hpp"
+
+// Producer/consumer pipeline that streams an endless sequence of fibonacci
+// terms(mod 2^64) in cache-line aligned blocks
+//
+// Generator threads run the SIMD kernel directly into ring buffer slots and
+// consumers read those same slots in-place. A full ring stalls its generator
+// and an empty ring stalls its consumer, both are counted in StageMetrics.
+
+constexpr std::size_t BlockTerms = 1024;
+
+struct alignas(CacheLineSize) TermBlock
+{
+	std::uint64_t Terms[BlockTerms];
+	// Index of Terms[0] within the sequence
+	std::uint64_t Index;
+};
+
+struct StageMetrics
+{
+	std::uint64_t Blocks   = 0;
+	// Number of times this stage had to wait on a full or empty ring
+	std::uint64_t Stalls   = 0;
+	// Queue depth, sampled once per block
+	std::uint64_t DepthSum = 0;
+	std::uint64_t DepthMax = 0;
+	std::chrono::high_resolution_clock::time_point Start;
+	std::chrono::high_resolution_clock::time_point Stop;
+
+	void Sample( std::size_t Depth )
+	{
+		++Blocks;
+		DepthSum += Depth;
+		DepthMax = std::max<std::uint64_t>(DepthMax, Depth);
+	}
+
+	double Seconds() const
+	{
+		return std::chrono::duration<double>(Stop - Start).count();
+	}
+
+	double TermsPerSecond() const
+	{
+		return static_cast<double>(Blocks * BlockTerms) / Seconds();
+	}
+
+	double AverageDepth() const
+	{
+		return Blocks ? static_cast<double>(DepthSum) / Blocks : 0.0;
+	}
+};
+
+// Spin for a little while before giving up the time slice
+inline void PipelineBackoff( std::size_t& Spins )
+{
+	if( Spins++ < 64 )
+	{
+		_mm_pause();
+	}
+	else
+	{
+		std::this_thread::yield();
+	}
+}
+
+// Fills a block with F(Index + 0..BlockTerms-1)
+inline void FillTermBlock( TermBlock& Block, std::uint64_t Index )
+{
+	Block.Index = Index;
+	FibGenerate64(Index, Block.Terms, BlockTerms);
+}
+
+// Several generator threads, each with its own single-producer/single-consumer
+// ring, generate interleaved blocks of the sequence. Generator i produces
+// blocks i, i + Generators, i + 2 * Generators, ... and the single consumer
+// visits the rings round-robin so blocks come out in sequence order.
+// Throws std::invalid_argument without at least one generator
+template< std::size_t Capacity = 8 >
+class OrderedFibStream
+{
+public:
+	using RingT = SPSCRing<TermBlock, Capacity>;
+
+	explicit OrderedFibStream( std::size_t Generators, std::uint64_t Start = 0 )
+		: Rings(Generators), Metrics(Generators), Running(true)
+	{
+		if( !Generators )
+		{
+			throw std::invalid_argument("OrderedFibStream needs at least one generator");
+		}
+		for( auto& Ring : Rings )
+		{
+			Ring = MakeAligned<RingT>();
+		}
+		for( std::size_t i = 0; i < Generators; ++i )
+		{
+			Threads.emplace_back(&OrderedFibStream::Generate, this, i, Start);
+		}
+	}
+
+	~OrderedFibStream()
+	{
+		Stop();
+	}
+
+	// Next block in sequence order, nullptr once stopped
+	const TermBlock* Acquire( StageMetrics& Consumer )
+	{
+		RingT& Ring = *Rings[NextRing];
+		std::size_t Spins = 0;
+		const TermBlock* Block;
+		while( (Block = Ring.TryAcquireRead()) == nullptr )
+		{
+			if( !Running.load(std::memory_order_relaxed) )
+			{
+				return nullptr;
+			}
+			Consumer.Stalls += Spins == 0;
+			PipelineBackoff(Spins);
+		}
+		Consumer.Sample(Ring.Depth());
+		return Block;
+	}
+
+	void Release()
+	{
+		Rings[NextRing]->ReleaseRead();
+		NextRing = (NextRing + 1) % Rings.size();
+	}
+
+	void Stop()
+	{
+		Running.store(false, std::memory_order_relaxed);
+		for( auto& Thread : Threads )
+		{
+			if( Thread.joinable() )
+			{
+				Thread.join();
+			}
+		}
+	}
+
+	// Only stable after Stop()
+	const std::vector<StageMetrics>& GeneratorMetrics() const
+	{
+		return Metrics;
+	}
+
+private:
+	void Generate( std::size_t Id, std::uint64_t Start )
+	{
+		RingT& Ring = *Rings[Id];
+		StageMetrics& Stage = Metrics[Id];
+		Stage.Start = std::chrono::high_resolution_clock::now();
+		for(
+			std::uint64_t Block = Id; Running.load(std::memory_order_relaxed);
+			Block += Rings.size()
+		)
+		{
+			std::size_t Spins = 0;
+			TermBlock* Slot;
+			while( (Slot = Ring.TryAcquireWrite()) == nullptr )
+			{
+				if( !Running.load(std::memory_order_relaxed) )
+				{
+					Stage.Stop = std::chrono::high_resolution_clock::now();
+					return;
+				}
+				Stage.Stalls += Spins == 0;
+				PipelineBackoff(Spins);
+			}
+			FillTermBlock(*Slot, Start + Block * BlockTerms);
+			Ring.CommitWrite();
+			Stage.Sample(Ring.Depth());
+		}
+		Stage.Stop = std::chrono::high_resolution_clock::now();
+	}
+
+	std::vector<AlignedPtr<RingT>> Rings;
+	std::vector<StageMetrics> Metrics;
+	std::vector<std::thread> Threads;
+	std::atomic<bool> Running;
+	std::size_t NextRing = 0;
+};
+
+// One generator thread feeding a single-producer/multi-consumer ring, for
+// consumers that do not care about the order in which blocks arrive
+template< std::size_t Capacity = 16 >
+class SharedFibStream
+{
+public:
+	using RingT = SPMCRing<TermBlock, Capacity>;
+
+	explicit SharedFibStream( std::uint64_t Start = 0 )
+		: Ring(MakeAligned<RingT>()), Running(true),
+		Thread(&SharedFibStream::Generate, this, Start)
+	{
+	}
+
+	~SharedFibStream()
+	{
+		Stop();
+	}
+
+	// Any block that is ready, nullptr once stopped
+	// Safe to call from any number of consumer threads
+	const TermBlock* Acquire( std::size_t& Ticket, StageMetrics& Consumer )
+	{
+		std::size_t Spins = 0;
+		const TermBlock* Block;
+		while( (Block = Ring->TryAcquireRead(Ticket)) == nullptr )
+		{
+			if( !Running.load(std::memory_order_relaxed) )
+			{
+				return nullptr;
+			}
+			Consumer.Stalls += Spins == 0;
+			PipelineBackoff(Spins);
+		}
+		Consumer.Sample(Ring->Depth());
+		return Block;
+	}
+
+	void Release( std::size_t Ticket )
+	{
+		Ring->ReleaseRead(Ticket);
+	}
+
+	void Stop()
+	{
+		Running.store(false, std::memory_order_relaxed);
+		if( Thread.joinable() )
+		{
+			Thread.join();
+		}
+	}
+
+	// Only stable after Stop()
+	const StageMetrics& GeneratorMetrics() const
+	{
+		return Metrics;
+	}
+
+private:
+	void Generate( std::uint64_t Start )
+	{
+		Metrics.Start = std::chrono::high_resolution_clock::now();
+		for( std::uint64_t Block = 0; Running.load(std::memory_order_relaxed); ++Block )
+		{
+			std::size_t Spins = 0;
+			TermBlock* Slot;
+			while( (Slot = Ring->TryAcquireWrite()) == nullptr )
+			{
+				if( !Running.load(std::memory_order_relaxed) )
+				{
+					Metrics.Stop = std::chrono::high_resolution_clock::now();
+					return;
+				}
+				Metrics.Stalls += Spins == 0;
+				PipelineBackoff(Spins);
+			}
+			FillTermBlock(*Slot, Start + Block * BlockTerms);
+			Ring->CommitWrite();
+			Metrics.Sample(Ring->Depth());
+		}
+		Metrics.Stop = std::chrono::high_resolution_clock::now();
+	}
+
+	AlignedPtr<RingT> Ring;
+	StageMetrics Metrics;
+	std::atomic<bool> Running;
+	std::thread Thread;
+};
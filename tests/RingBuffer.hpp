@@ -0,0 +1,233 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include <immintrin.h>
+
+// Bounded lock-free ring buffers of fixed-size slots
+//
+// Slots are handed out in-place so producers fill them and consumers read
+// them without copying: Acquire a slot, use it, then Commit/Release it.
+// Acquire returns nullptr when the ring is full/empty, which is how
+// backpressure gets pushed back to the caller.
+
+constexpr std::size_t CacheLineSize = 64;
+
+// Cache-line aligned slot storage
+template< typename T, std::size_t Capacity >
+struct AlignedSlots
+{
+	static_assert(
+		Capacity && !(Capacity & (Capacity - 1)), "Capacity must be a power of two"
+	);
+	static_assert(
+		std::is_trivially_destructible<T>::value, "Slots are never destructed"
+	);
+
+	AlignedSlots()
+		: Data(static_cast<T*>(_mm_malloc(sizeof(T) * Capacity, CacheLineSize)))
+	{
+		if( Data == nullptr )
+		{
+			throw std::bad_alloc();
+		}
+	}
+	~AlignedSlots()
+	{
+		_mm_free(Data);
+	}
+	AlignedSlots( const AlignedSlots& ) = delete;
+	AlignedSlots& operator=( const AlignedSlots& ) = delete;
+
+	T& operator[]( std::size_t Index )
+	{
+		return Data[Index & (Capacity - 1)];
+	}
+
+	T* Data;
+};
+
+// Single-producer/single-consumer
+template< typename T, std::size_t Capacity >
+class SPSCRing
+{
+public:
+	// Producer side
+	T* TryAcquireWrite()
+	{
+		const std::size_t Head = WriteIndex.load(std::memory_order_relaxed);
+		if( Head - CachedReadIndex == Capacity )
+		{
+			CachedReadIndex = ReadIndex.load(std::memory_order_acquire);
+			if( Head - CachedReadIndex == Capacity )
+			{
+				return nullptr;
+			}
+		}
+		return &Slots[Head];
+	}
+
+	void CommitWrite()
+	{
+		WriteIndex.store(
+			WriteIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release
+		);
+	}
+
+	// Consumer side
+	const T* TryAcquireRead()
+	{
+		const std::size_t Tail = ReadIndex.load(std::memory_order_relaxed);
+		if( Tail == CachedWriteIndex )
+		{
+			CachedWriteIndex = WriteIndex.load(std::memory_order_acquire);
+			if( Tail == CachedWriteIndex )
+			{
+				return nullptr;
+			}
+		}
+		return &Slots[Tail];
+	}
+
+	void ReleaseRead()
+	{
+		ReadIndex.store(
+			ReadIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release
+		);
+	}
+
+	// Number of committed slots not yet released, safe from either side
+	std::size_t Depth() const
+	{
+		return WriteIndex.load(std::memory_order_relaxed)
+			- ReadIndex.load(std::memory_order_relaxed);
+	}
+
+private:
+	// Each side only ever writes to its own cache line
+	alignas(CacheLineSize) std::atomic<std::size_t> WriteIndex{0};
+	std::size_t CachedReadIndex = 0;
+	alignas(CacheLineSize) std::atomic<std::size_t> ReadIndex{0};
+	std::size_t CachedWriteIndex = 0;
+	alignas(CacheLineSize) AlignedSlots<T, Capacity> Slots;
+};
+
+// Single-producer/multi-consumer
+// Every slot carries a sequence number(same scheme as Dmitry Vyukov's bounded
+// queue) so consumers may claim slots concurrently and release them in any
+// order. A slot only becomes writable again once its consumer released it.
+template< typename T, std::size_t Capacity >
+class SPMCRing
+{
+public:
+	SPMCRing()
+	{
+		for( std::size_t i = 0; i < Capacity; ++i )
+		{
+			new (&Sequence[i]) SlotSequence;
+			Sequence[i].Value.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	// Producer side
+	T* TryAcquireWrite()
+	{
+		const std::size_t Head = WriteIndex.load(std::memory_order_relaxed);
+		if( Sequence[Head].Value.load(std::memory_order_acquire) != Head )
+		{
+			return nullptr;
+		}
+		return &Slots[Head];
+	}
+
+	void CommitWrite()
+	{
+		const std::size_t Head = WriteIndex.load(std::memory_order_relaxed);
+		Sequence[Head].Value.store(Head + 1, std::memory_order_release);
+		WriteIndex.store(Head + 1, std::memory_order_relaxed);
+	}
+
+	// Consumer side, Ticket is handed back to ReleaseRead
+	const T* TryAcquireRead( std::size_t& Ticket )
+	{
+		std::size_t Tail = ReadIndex.load(std::memory_order_relaxed);
+		while( true )
+		{
+			const std::size_t Seq = Sequence[Tail].Value.load(std::memory_order_acquire);
+			const std::ptrdiff_t Ready = static_cast<std::ptrdiff_t>(Seq - (Tail + 1));
+			if( Ready == 0 )
+			{
+				if(
+					ReadIndex.compare_exchange_weak(
+						Tail, Tail + 1, std::memory_order_relaxed
+					)
+				)
+				{
+					Ticket = Tail;
+					return &Slots[Tail];
+				}
+			}
+			else if( Ready < 0 )
+			{
+				return nullptr;
+			}
+			else
+			{
+				Tail = ReadIndex.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	void ReleaseRead( std::size_t Ticket )
+	{
+		Sequence[Ticket].Value.store(Ticket + Capacity, std::memory_order_release);
+	}
+
+	std::size_t Depth() const
+	{
+		return WriteIndex.load(std::memory_order_relaxed)
+			- ReadIndex.load(std::memory_order_relaxed);
+	}
+
+private:
+	struct alignas(CacheLineSize) SlotSequence
+	{
+		std::atomic<std::size_t> Value;
+	};
+
+	alignas(CacheLineSize) std::atomic<std::size_t> WriteIndex{0};
+	alignas(CacheLineSize) std::atomic<std::size_t> ReadIndex{0};
+	AlignedSlots<SlotSequence, Capacity> Sequence;
+	AlignedSlots<T, Capacity> Slots;
+};
+
+// Over-aligned heap objects, since operator new only guarantees alignment of
+// alignof(std::max_align_t) before C++17
+template< typename T >
+struct AlignedDelete
+{
+	void operator()( T* Object ) const
+	{
+		Object->~T();
+		_mm_free(Object);
+	}
+};
+
+template< typename T >
+using AlignedPtr = std::unique_ptr<T, AlignedDelete<T>>;
+
+template< typename T, typename... ArgsT >
+AlignedPtr<T> MakeAligned( ArgsT&&... Arguments )
+{
+	void* Memory = _mm_malloc(sizeof(T), alignof(T));
+	if( Memory == nullptr )
+	{
+		throw std::bad_alloc();
+	}
+	return AlignedPtr<T>(new (Memory) T(std::forward<ArgsT>(Arguments)...));
+}
@@ -6,6 +6,8 @@
 #include <chrono>
 #include <tuple>
 
+#include "Bench.hpp"
+
 #ifdef _WIN32
 #include <intrin.h>
 #define NOMINMAX
@@ -84,39 +86,6 @@ std::string GetProcessorBrandString()
 
 #endif
 
-template< typename TimeT = std::chrono::nanoseconds >
-struct Bench
-{
-
-	// Returns a tuple of (Time, Function return value)
-	template< typename FunctionT, typename ...ArgsT >
-	static std::tuple<
-		TimeT,
-		typename std::result_of<FunctionT(ArgsT...)>::type
-	> BenchResult(
-		FunctionT&& Func,
-		ArgsT&&... Arguments
-	)
-	{
-		const auto Start = std::chrono::high_resolution_clock::now();
-
-		typename std::result_of<FunctionT(ArgsT...)>::type ReturnValue = std::forward<FunctionT>(Func)(
-			std::forward<ArgsT>(Arguments)...
-		);
-		const auto Stop = std::chrono::high_resolution_clock::now();
-
-		return std::make_tuple<
-			TimeT,
-			typename std::result_of<FunctionT(ArgsT...)>::type
-		>(
-			std::chrono::duration_cast<TimeT>(
-				Stop - Start
-				),
-			std::move(ReturnValue)
-		);
-	}
-};
-
 const static std::uint64_t FibMod64[] = {
 0U,
 1U,
@@ -0,0 +1,352 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <string>
+#include <algorithm>
+#include <utility>
+
+#include <immintrin.h>
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+// Fixed-width unsigned integers of 64-bit limbs(least significant limb first)
+// All arithmetic wraps around mod 2^(64 * Words), so fibonacci terms that fit
+// within the width come out exact and anything beyond it keeps its low bits.
+template< std::size_t Words >
+struct WideUInt
+{
+	std::array<std::uint64_t, Words> Limb;
+
+	static WideUInt Zero()
+	{
+		WideUInt Result;
+		Result.Limb.fill(0);
+		return Result;
+	}
+
+	static WideUInt From( std::uint64_t Value )
+	{
+		WideUInt Result = Zero();
+		Result.Limb[0] = Value;
+		return Result;
+	}
+
+	bool operator==( const WideUInt& Other ) const
+	{
+		return Limb == Other.Limb;
+	}
+
+	bool operator!=( const WideUInt& Other ) const
+	{
+		return Limb != Other.Limb;
+	}
+
+	// Number of significant bits
+	std::size_t BitWidth() const
+	{
+		for( std::size_t i = Words; i-- > 0; )
+		{
+			if( Limb[i] )
+			{
+				#ifdef _MSC_VER
+				return i * 64 + 64 - __lzcnt64(Limb[i]);
+				#else
+				return i * 64 + 64 - __builtin_clzll(Limb[i]);
+				#endif
+			}
+		}
+		return 0;
+	}
+
+	// Decimal representation, peeling off 9 digits at a time
+	std::string ToString() const
+	{
+		std::array<std::uint32_t, Words * 2> Halves;
+		for( std::size_t i = 0; i < Words; ++i )
+		{
+			Halves[i * 2 + 0] = static_cast<std::uint32_t>(Limb[i]);
+			Halves[i * 2 + 1] = static_cast<std::uint32_t>(Limb[i] >> 32);
+		}
+
+		std::string Digits;
+		bool NonZero = true;
+		while( NonZero )
+		{
+			NonZero = false;
+			std::uint64_t Remainder = 0;
+			for( std::size_t i = Halves.size(); i-- > 0; )
+			{
+				const std::uint64_t Cur = (Remainder << 32) | Halves[i];
+				Halves[i] = static_cast<std::uint32_t>(Cur / 1000000000U);
+				Remainder = Cur % 1000000000U;
+				NonZero |= Halves[i] != 0;
+			}
+			for( std::size_t i = 0; i < 9 && (NonZero || Remainder); ++i )
+			{
+				Digits.push_back(static_cast<char>('0' + Remainder % 10));
+				Remainder /= 10;
+			}
+		}
+		if( Digits.empty() )
+		{
+			Digits.push_back('0');
+		}
+		std::reverse(Digits.begin(), Digits.end());
+		return Digits;
+	}
+};
+
+using UInt128 = WideUInt<2>;
+using UInt256 = WideUInt<4>;
+
+// Largest n for which F(n) fits within Words limbs without wrapping around
+// F(n) ~ phi^n / sqrt(5) < 2^(64 * Words)
+constexpr std::size_t WideFibMaxIndex( std::size_t Words )
+{
+	return static_cast<std::size_t>(
+		(64.0 * Words + 1.1609640474436813) / 0.6942419136306174
+	);
+}
+
+static_assert(WideFibMaxIndex(1) ==  93, "F(93) is the last term to fit in 64 bits");
+static_assert(WideFibMaxIndex(2) == 186, "F(186) is the last term to fit in 128 bits");
+static_assert(WideFibMaxIndex(4) == 370, "F(370) is the last term to fit in 256 bits");
+
+namespace WideOps
+{
+inline std::uint8_t AddCarry(
+	std::uint8_t Carry, std::uint64_t A, std::uint64_t B, std::uint64_t& Sum
+)
+{
+	unsigned long long Result;
+	Carry = _addcarry_u64(Carry, A, B, &Result);
+	Sum = Result;
+	return Carry;
+}
+
+inline std::uint8_t SubBorrow(
+	std::uint8_t Borrow, std::uint64_t A, std::uint64_t B, std::uint64_t& Difference
+)
+{
+	unsigned long long Result;
+	Borrow = _subborrow_u64(Borrow, A, B, &Result);
+	Difference = Result;
+	return Borrow;
+}
+
+// Full 64x64->128 bit product
+inline std::uint64_t MulWide( std::uint64_t A, std::uint64_t B, std::uint64_t& High )
+{
+	#ifdef _MSC_VER
+	unsigned long long Hi;
+	const std::uint64_t Low = _umul128(A, B, &Hi);
+	High = Hi;
+	return Low;
+	#else
+	const unsigned __int128 Product = static_cast<unsigned __int128>(A) * B;
+	High = static_cast<std::uint64_t>(Product >> 64);
+	return static_cast<std::uint64_t>(Product);
+	#endif
+}
+
+template< std::size_t Words >
+WideUInt<Words> Add( const WideUInt<Words>& A, const WideUInt<Words>& B )
+{
+	WideUInt<Words> Result;
+	std::uint8_t Carry = 0;
+	for( std::size_t i = 0; i < Words; ++i )
+	{
+		Carry = AddCarry(Carry, A.Limb[i], B.Limb[i], Result.Limb[i]);
+	}
+	return Result;
+}
+
+#if defined(__AVX2__)
+// All four limbs are added in parallel and the carries are then resolved
+// all at once using the mask of lanes that generate a carry(G) and the mask
+// of lanes that would propagate an incoming carry(P, all bits set):
+//  Carry-In = ((G << 1) + P) ^ P
+// Which is the same trick a carry-lookahead adder uses, but on four lanes.
+inline WideUInt<4> Add( const WideUInt<4>& A, const WideUInt<4>& B )
+{
+	const __m256i LaneA = _mm256_loadu_si256(
+		reinterpret_cast<const __m256i*>(A.Limb.data())
+	);
+	const __m256i LaneB = _mm256_loadu_si256(
+		reinterpret_cast<const __m256i*>(B.Limb.data())
+	);
+	const __m256i Sum = _mm256_add_epi64(LaneA, LaneB);
+
+	// Unsigned Sum < A, by biasing both into signed range
+	const __m256i Bias = _mm256_set1_epi64x(
+		static_cast<std::int64_t>(0x8000000000000000ULL)
+	);
+	const __m256i Generate = _mm256_cmpgt_epi64(
+		_mm256_xor_si256(LaneA, Bias), _mm256_xor_si256(Sum, Bias)
+	);
+	const __m256i Propagate = _mm256_cmpeq_epi64(Sum, _mm256_set1_epi64x(-1));
+
+	const std::uint32_t G = _mm256_movemask_pd(_mm256_castsi256_pd(Generate));
+	const std::uint32_t P = _mm256_movemask_pd(_mm256_castsi256_pd(Propagate));
+	const std::uint32_t CarryIn = ((G << 1) + P) ^ P;
+
+	// Expand the 4-bit mask back into lanes of all-ones and subtract
+	const __m256i LaneBits = _mm256_set_epi64x(8, 4, 2, 1);
+	const __m256i CarryMask = _mm256_cmpeq_epi64(
+		_mm256_and_si256(_mm256_set1_epi64x(CarryIn), LaneBits), LaneBits
+	);
+
+	WideUInt<4> Result;
+	_mm256_storeu_si256(
+		reinterpret_cast<__m256i*>(Result.Limb.data()),
+		_mm256_sub_epi64(Sum, CarryMask)
+	);
+	return Result;
+}
+#endif
+
+template< std::size_t Words >
+WideUInt<Words> Sub( const WideUInt<Words>& A, const WideUInt<Words>& B )
+{
+	WideUInt<Words> Result;
+	std::uint8_t Borrow = 0;
+	for( std::size_t i = 0; i < Words; ++i )
+	{
+		Borrow = SubBorrow(Borrow, A.Limb[i], B.Limb[i], Result.Limb[i]);
+	}
+	return Result;
+}
+
+// Schoolbook product, truncated to the lower Words limbs
+template< std::size_t Words >
+WideUInt<Words> Mul( const WideUInt<Words>& A, const WideUInt<Words>& B )
+{
+	WideUInt<Words> Result = WideUInt<Words>::Zero();
+	for( std::size_t i = 0; i < Words; ++i )
+	{
+		if( A.Limb[i] == 0 )
+		{
+			continue;
+		}
+		std::uint64_t Carry = 0;
+		for( std::size_t j = 0; i + j < Words; ++j )
+		{
+			std::uint64_t High;
+			std::uint64_t Low = MulWide(A.Limb[i], B.Limb[j], High);
+			High += AddCarry(0, Low, Result.Limb[i + j], Low);
+			High += AddCarry(0, Low, Carry, Low);
+			Result.Limb[i + j] = Low;
+			Carry = High;
+		}
+	}
+	return Result;
+}
+}
+
+template< std::size_t Words >
+inline WideUInt<Words> operator+( const WideUInt<Words>& A, const WideUInt<Words>& B )
+{
+	return WideOps::Add(A, B);
+}
+
+template< std::size_t Words >
+inline WideUInt<Words> operator-( const WideUInt<Words>& A, const WideUInt<Words>& B )
+{
+	return WideOps::Sub(A, B);
+}
+
+template< std::size_t Words >
+inline WideUInt<Words> operator*( const WideUInt<Words>& A, const WideUInt<Words>& B )
+{
+	return WideOps::Mul(A, B);
+}
+
+// Fast doubling, same as the Chun-Min Chang method but on wide integers
+// Returns the pair F(n), F(n + 1)
+template< std::size_t Words >
+std::pair<WideUInt<Words>, WideUInt<Words>> FibWidePair( std::uint64_t n )
+{
+	WideUInt<Words> a = WideUInt<Words>::Zero(); // F(0) = 0
+	WideUInt<Words> b = WideUInt<Words>::From(1); // F(1) = 1
+	if( n == 0 )
+	{
+		return std::make_pair(a, b);
+	}
+	#ifdef _MSC_VER
+	const std::uint64_t h = 64 - __lzcnt64(n);
+	#else
+	const std::uint64_t h = 64 - __builtin_clzll(n);
+	#endif
+	for( std::uint64_t mask = 1ULL << (h - 1); mask; mask >>= 1 )
+	{
+		const WideUInt<Words> c = a * ((b + b) - a); // F(2k) = F(k) * [ 2 * F(k+1) – F(k) ]
+		const WideUInt<Words> d = a * a + b * b;     // F(2k+1) = F(k)^2 + F(k+1)^2
+		if( mask & n )
+		{
+			a = d;
+			b = c + d;
+		}
+		else
+		{
+			a = c;
+			b = d;
+		}
+	}
+	return std::make_pair(a, b);
+}
+
+// Exact for n <= WideFibMaxIndex(Words), F(n) mod 2^(64 * Words) beyond that
+template< std::size_t Words >
+WideUInt<Words> FibWide( std::uint64_t n )
+{
+	return FibWidePair<Words>(n).first;
+}
+
+// Sequential generator of consecutive terms, starting at any index
+template< std::size_t Words >
+struct WideFibGenerator
+{
+	explicit WideFibGenerator( std::uint64_t Start = 0 )
+		: Index(Start)
+	{
+		const auto Pair = FibWidePair<Words>(Start);
+		Cur = Pair.first;
+		Next = Pair.second;
+	}
+
+	std::uint64_t GetIndex() const
+	{
+		return Index;
+	}
+
+	const WideUInt<Words>& Get() const
+	{
+		return Cur;
+	}
+
+	void Advance()
+	{
+		const WideUInt<Words> Sum = Cur + Next;
+		Cur = Next;
+		Next = Sum;
+		++Index;
+	}
+
+	// Writes the next Count terms into Out
+	void Generate( WideUInt<Words>* Out, std::size_t Count )
+	{
+		for( std::size_t i = 0; i < Count; ++i )
+		{
+			Out[i] = Cur;
+			Advance();
+		}
+	}
+
+private:
+	std::uint64_t Index;
+	WideUInt<Words> Cur;
+	WideUInt<Words> Next;
+};
@@ -0,0 +1,223 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "TestTools.hpp"
+#include "FibKernels.hpp"
+#include "FibBatch.hpp"
+#include "FibAggregate.hpp"
+
+// Range aggregates checked against adding up every generated term, then
+// timed against doing just that, ns per query
+
+#define ColumnWidth 14
+
+// Sum, sum of squares, and weighted sum of every term in the range
+struct BruteForce
+{
+	std::uint64_t Sum = 0;
+	std::uint64_t Squares = 0;
+	std::uint64_t Weighted = 0;
+};
+
+BruteForce Generated(
+	std::uint64_t First, std::uint64_t Last,
+	const std::vector<std::uint64_t>& Weights, std::uint64_t Modulus
+)
+{
+	BruteForce Result;
+	if( Last < First )
+	{
+		return Result;
+	}
+	const std::uint64_t Count = Last - First + 1;
+	std::vector<std::uint64_t> Terms((Count + 3) & ~std::uint64_t(3));
+	if( Modulus == 0 )
+	{
+		FibGenerate64(First, Terms.data(), Terms.size());
+	}
+	else
+	{
+		auto Pair = FibModPair(First, Modulus);
+		for( std::uint64_t& Term : Terms )
+		{
+			Term = Pair.first;
+			Pair = std::make_pair(
+				Pair.second,
+				static_cast<std::uint64_t>((static_cast<unsigned __int128>(Pair.first) + Pair.second) % Modulus)
+			);
+		}
+	}
+	const auto Reduce = [Modulus]( unsigned __int128 Value )
+	{
+		return static_cast<std::uint64_t>(Modulus ? Value % Modulus : Value);
+	};
+	for( std::uint64_t i = 0; i < Count; ++i )
+	{
+		// Wide enough that neither a product nor a sum wraps before reducing
+		const unsigned __int128 Term = Terms[i];
+		const unsigned __int128 Weight = Reduce(Weights[(First + i) % Weights.size()]);
+		Result.Sum      = Reduce(Result.Sum + Term);
+		Result.Squares  = Reduce(Result.Squares + static_cast<unsigned __int128>(Reduce(Term * Term)));
+		Result.Weighted = Reduce(Result.Weighted + static_cast<unsigned __int128>(Reduce(Weight * Term)));
+	}
+	return Result;
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	bool Passed = true;
+
+	std::mt19937_64 Random(0);
+	const std::uint64_t Moduli[] = { 0, 1, 2, 1000000007, 0xFFFFFFFFFFFFFFC5 };
+	std::uniform_int_distribution<std::uint64_t> FirstIndex(0, 1ULL << 40);
+	std::uniform_int_distribution<std::uint64_t> Length(0, 3 * FibAggregateShortRange);
+	std::uniform_int_distribution<std::size_t> PeriodLength(1, 13);
+	std::size_t Checked = 0;
+	for( const std::uint64_t Modulus : Moduli )
+	{
+		for( std::size_t Round = 0; Round < 200; ++Round )
+		{
+			std::uint64_t First = FirstIndex(Random);
+			std::uint64_t Last = First + Length(Random);
+			// Edges: empty, single, from zero, and at the very top
+			switch( Round )
+			{
+			case 0: Last = First - 1; break;
+			case 1: Last = First; break;
+			case 2: Last -= First; First = 0; break;
+			case 3: Last = ~std::uint64_t(0); First = Last - 1000; break;
+			}
+			std::vector<std::uint64_t> Weights(PeriodLength(Random));
+			for( std::uint64_t& Weight : Weights )
+			{
+				Weight = Random();
+			}
+			const BruteForce Expected = Generated(First, Last, Weights, Modulus);
+			Passed &= FibRangeSum(First, Last, Modulus) == Expected.Sum;
+			Passed &= FibRangeSquareSum(First, Last, Modulus) == Expected.Squares;
+			Passed &= FibRangeWeightedSum(First, Last, Weights.data(), Weights.size(), Modulus) == Expected.Weighted;
+			++Checked;
+		}
+	}
+
+	// Far past anything that could be generated, against the closed forms
+	// F(0) + ... + F(n) = F(n + 2) - 1 and F(0)^2 + ... + F(n)^2 = F(n)F(n + 1)
+	for( const std::uint64_t n : { 1ULL << 40, 123456789012345ULL, (1ULL << 62) + 12345 } )
+	{
+		const auto Pair = FibPair<std::uint64_t>(n);
+		Passed &= FibRangeSum(0, n) == Pair.first + Pair.second - 1;
+		Passed &= FibRangeSquareSum(0, n) == Pair.first * Pair.second;
+		const std::uint64_t One = 1;
+		Passed &= FibRangeWeightedSum(0, n, &One, 1) == Pair.first + Pair.second - 1;
+	}
+	std::cout
+		<< Checked << " ranges against brute force "
+		<< (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+
+	const std::vector<std::uint64_t> Weights = { 3, 1, 4, 1, 5, 9, 2 };
+	std::cout
+		<< std::setw(ColumnWidth) << "Length"
+		<< std::setw(ColumnWidth) << "Generate"
+		<< std::setw(ColumnWidth) << "Sum"
+		<< std::setw(ColumnWidth) << "Squares"
+		<< std::setw(ColumnWidth) << "Weighted(7)"
+		<< std::setw(ColumnWidth) << "Sum mod p" << std::endl;
+	constexpr std::size_t Queries = 256;
+	std::vector<std::uint64_t> Firsts(Queries);
+	for( std::uint64_t& First : Firsts )
+	{
+		First = FirstIndex(Random);
+	}
+	for(
+		const std::uint64_t Span : {
+			std::uint64_t(16), std::uint64_t(64), FibAggregateShortRange,
+			FibAggregateShortRange + 1, std::uint64_t(4096), std::uint64_t(1) << 20,
+			std::uint64_t(1) << 40
+		}
+	)
+	{
+		std::uint64_t Sink = 0;
+		std::cout << std::setw(ColumnWidth) << Span;
+		if( Span <= (1 << 20) )
+		{
+			std::vector<std::uint64_t> Terms((Span + 3) & ~std::uint64_t(3));
+			std::cout << std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> std::uint64_t
+				{
+					for( const std::uint64_t First : Firsts )
+					{
+						FibGenerate64(First, Terms.data(), Terms.size());
+						std::uint64_t Sum = 0;
+						for( std::uint64_t i = 0; i < Span; ++i )
+						{
+							Sum += Terms[i];
+						}
+						Sink += Sum;
+					}
+					return Sink;
+				},
+				Queries
+			);
+		}
+		else
+		{
+			std::cout << std::setw(ColumnWidth) << '-';
+		}
+		std::cout
+			<< std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> std::uint64_t
+				{
+					for( const std::uint64_t First : Firsts )
+					{
+						Sink += FibRangeSum(First, First + Span - 1);
+					}
+					return Sink;
+				},
+				Queries
+			)
+			<< std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> std::uint64_t
+				{
+					for( const std::uint64_t First : Firsts )
+					{
+						Sink += FibRangeSquareSum(First, First + Span - 1);
+					}
+					return Sink;
+				},
+				Queries
+			)
+			<< std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> std::uint64_t
+				{
+					for( const std::uint64_t First : Firsts )
+					{
+						Sink += FibRangeWeightedSum(First, First + Span - 1, Weights.data(), Weights.size());
+					}
+					return Sink;
+				},
+				Queries
+			)
+			<< std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> std::uint64_t
+				{
+					for( const std::uint64_t First : Firsts )
+					{
+						Sink += FibRangeSum(First, First + Span - 1, 1000000007);
+					}
+					return Sink;
+				},
+				Queries
+			) << std::endl;
+	}
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
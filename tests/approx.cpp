@@ -0,0 +1,204 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "TestTools.hpp"
+#include "BigUInt.hpp"
+#include "FibApprox.hpp"
+
+// Approximate magnitudes of F(n), measured against exact bignum terms for
+// accuracy and against a scalar std::pow of Binet's formula for speed
+
+// Distance between two doubles in units of the last place
+std::uint64_t UlpDistance( double A, double B )
+{
+	std::int64_t BitsA, BitsB;
+	std::memcpy(&BitsA, &A, sizeof(double));
+	std::memcpy(&BitsB, &B, sizeof(double));
+	return static_cast<std::uint64_t>(BitsA > BitsB ? BitsA - BitsB : BitsB - BitsA);
+}
+
+// Correctly rounded double of an exact term, and its leading digits
+struct ExactTerm
+{
+	double Value;
+	double Mantissa;
+	std::uint64_t Exponent;
+	double Log10;
+};
+
+ExactTerm Exact( std::uint64_t n )
+{
+	const std::string Digits = FibBig(n).ToString();
+	ExactTerm Term;
+	Term.Value = std::strtod(Digits.c_str(), nullptr);
+	const std::string Leading = Digits.substr(0, 1) + "." + Digits.substr(1, 24);
+	Term.Mantissa = std::strtod(Leading.c_str(), nullptr);
+	Term.Exponent = Digits.size() - 1;
+	Term.Log10 = Term.Exponent + std::log10(Term.Mantissa);
+	return Term;
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	bool Passed = true;
+
+	const double Phi = (1.0 + std::sqrt(5.0)) / 2.0;
+	const auto NaiveBinet = [Phi]( std::uint64_t n ) -> double
+	{
+		return std::round(std::pow(Phi, static_cast<double>(n)) / std::sqrt(5.0));
+	};
+
+	// Every double-sized term
+	std::vector<std::uint64_t> Indices;
+	for( std::uint64_t n = 0; n <= FibApproxMaxIndex + 1; ++n )
+	{
+		Indices.push_back(n);
+	}
+	std::vector<double> Values(Indices.size());
+	std::vector<double> Log10s(Indices.size());
+	std::vector<double> Mantissas(Indices.size());
+	std::vector<std::uint64_t> Exponents(Indices.size());
+	FibApproxBatch(Indices.data(), Values.data(), Indices.size());
+	FibLog10Batch(Indices.data(), Log10s.data(), Indices.size());
+	FibLeadingBatch(Indices.data(), Mantissas.data(), Exponents.data(), Indices.size());
+
+	std::uint64_t ValueUlps = 0, NaiveUlps = 0, Log10Ulps = 0;
+	double MantissaError = 0.0;
+	std::uint64_t ExactBelow = 0, NaiveExactBelow = 0;
+	bool ExponentsMatch = true;
+	for( std::uint64_t n = 0; n <= FibApproxMaxIndex; ++n )
+	{
+		const ExactTerm Term = Exact(n);
+		ValueUlps = std::max(ValueUlps, UlpDistance(Values[n], Term.Value));
+		// The naive power overflows before F(n) does
+		if( std::isfinite(NaiveBinet(n)) )
+		{
+			NaiveUlps = std::max(NaiveUlps, UlpDistance(NaiveBinet(n), Term.Value));
+		}
+		if( ExactBelow == n && std::round(Values[n]) == Term.Value )
+		{
+			++ExactBelow;
+		}
+		if( NaiveExactBelow == n && NaiveBinet(n) == Term.Value )
+		{
+			++NaiveExactBelow;
+		}
+		if( n )
+		{
+			Log10Ulps = std::max(Log10Ulps, UlpDistance(Log10s[n], Term.Log10));
+			MantissaError = std::max(MantissaError, std::abs(Mantissas[n] / Term.Mantissa - 1.0));
+			ExponentsMatch &= Exponents[n] == Term.Exponent;
+		}
+	}
+	Passed &= std::isinf(Values[FibApproxMaxIndex + 1]);
+	Passed &= Values[0] == 0.0 && Mantissas[0] == 0.0 && Exponents[0] == 0;
+	Passed &= std::isinf(Log10s[0]) && Log10s[0] < 0.0;
+	Passed &= ExactBelow >= FibApproxExactIndex;
+	Passed &= ValueUlps <= 2 && Log10Ulps <= 1 && MantissaError <= 4.5e-16 && ExponentsMatch;
+
+	// Leading digits far past the exponent range of a double
+	std::mt19937_64 Random(0);
+	std::vector<std::uint64_t> Far = { 1477, 4096, 10000, 65536, 100000 };
+	std::uniform_int_distribution<std::uint64_t> FarIndex(FibApproxMaxIndex, 100000);
+	for( std::size_t i = 0; i < 11; ++i )
+	{
+		Far.push_back(FarIndex(Random));
+	}
+	std::vector<double> FarMantissas(Far.size());
+	std::vector<std::uint64_t> FarExponents(Far.size());
+	FibLeadingBatch(Far.data(), FarMantissas.data(), FarExponents.data(), Far.size());
+	double FarError = 0.0;
+	for( std::size_t i = 0; i < Far.size(); ++i )
+	{
+		const ExactTerm Term = Exact(Far[i]);
+		FarError = std::max(FarError, std::abs(FarMantissas[i] / Term.Mantissa - 1.0));
+		Passed &= FarExponents[i] == Term.Exponent;
+	}
+	Passed &= FarError <= 4.5e-16;
+
+	std::cout
+		<< "Binet:       max " << ValueUlps << " ulp, exact when rounded below F(" << ExactBelow << ")\n"
+		<< "std::pow:    max " << NaiveUlps << " ulp, exact below F(" << NaiveExactBelow << ")\n"
+		<< "log10:       max " << Log10Ulps << " ulp\n"
+		<< std::scientific << std::setprecision(2)
+		<< "Mantissa:    max " << MantissaError << " relative error up to F(" << FibApproxMaxIndex << ")\n"
+		<< "             max " << FarError << " relative error up to F(100000)\n";
+	{
+		const std::uint64_t Huge[] = { 1ULL << 40, FibApproxMaxLogIndex };
+		double HugeMantissas[2];
+		std::uint64_t HugeExponents[2];
+		FibLeadingBatch(Huge, HugeMantissas, HugeExponents, 2);
+		std::cout << std::setprecision(15);
+		for( std::size_t i = 0; i < 2; ++i )
+		{
+			std::cout
+				<< "F(" << Huge[i] << ") ~ " << std::fixed << HugeMantissas[i]
+				<< "e" << HugeExponents[i] << '\n';
+		}
+	}
+
+	// Throughput over random indices, ns per index
+	constexpr std::size_t Count = 1 << 16;
+	std::vector<std::uint64_t> Batch(Count), LogBatch(Count);
+	std::uniform_int_distribution<std::uint64_t> Index(0, FibApproxMaxIndex);
+	std::uniform_int_distribution<std::uint64_t> LogIndex(0, FibApproxMaxLogIndex);
+	for( std::size_t i = 0; i < Count; ++i )
+	{
+		Batch[i] = Index(Random);
+		LogBatch[i] = LogIndex(Random);
+	}
+	std::vector<double> Out(Count), Mantissa(Count);
+	std::vector<std::uint64_t> Exponent(Count);
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout
+		<< "std::pow:    " << Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				for( std::size_t i = 0; i < Count; ++i )
+				{
+					Out[i] = std::pow(Phi, static_cast<double>(Batch[i])) / std::sqrt(5.0);
+				}
+				return 0;
+			},
+			Count
+		) << "ns\n"
+		<< "Binet:       " << Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibApproxBatch(Batch.data(), Out.data(), Count);
+				return 0;
+			},
+			Count
+		) << "ns\n"
+		<< "log10:       " << Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibLog10Batch(LogBatch.data(), Out.data(), Count);
+				return 0;
+			},
+			Count
+		) << "ns\n"
+		<< "Leading:     " << Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibLeadingBatch(LogBatch.data(), Mantissa.data(), Exponent.data(), Count);
+				return 0;
+			},
+			Count
+		) << "ns\n";
+
+	std::cout << (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -16,6 +16,10 @@
 #include <glm/glm.hpp>
 
 #include "TestTools.hpp"
+#include "WideInt.hpp"
+#if defined(__AVX2__) && defined(__FMA__)
+#include "FibApprox.hpp"
+#endif
 
 struct FibMethod
 {
@@ -230,6 +234,45 @@ struct ChunMinAVX512 : FibMethod
 	}
 };
 #endif
+
+// Fast doubling over exact fixed-width integers. Exact up to F(186) and F(370)
+// respectively, only the lowest 64 bits are handed back for verification
+template< std::size_t Words >
+struct FastDoublingWide : FibMethod
+{
+	const char* GetName() const override
+	{
+		return Words == 2 ? "Wide-128" : "Wide-256";
+	}
+
+	std::uint64_t operator()(std::uint64_t n) override
+	{
+		return FibWide<Words>(n).Limb[0];
+	}
+};
+
+#if defined(__AVX2__) && defined(__FMA__)
+// Binet's formula in floating point, rounded back to an integer. Only exact
+// while F(n) is well within the 53-bit mantissa of a double
+struct BinetApprox : FibMethod
+{
+	std::size_t Limit() const override
+	{
+		return FibApproxExactIndex;
+	}
+	const char* GetName() const override
+	{
+		return FibApproxImpl::Width == 8 ? "Binet - AVX512" : "Binet - AVX2";
+	}
+
+	std::uint64_t operator()(std::uint64_t n) override
+	{
+		double Value;
+		FibApproxBatch(&n, &Value, 1);
+		return static_cast<std::uint64_t>(Value + 0.5);
+	}
+};
+#endif
 }
 
 const static std::unique_ptr<FibMethod> FibMethods[] = {
@@ -240,6 +283,11 @@ const static std::unique_ptr<FibMethod> FibMethods[] = {
 	std::make_unique<Methods::ChunMin>(),
 #if defined(__AVX512F__)
 	std::make_unique<Methods::ChunMinAVX512>(),
+#endif
+	std::make_unique<Methods::FastDoublingWide<2>>(),
+	std::make_unique<Methods::FastDoublingWide<4>>(),
+#if defined(__AVX2__) && defined(__FMA__)
+	std::make_unique<Methods::BinetApprox>(),
 #endif
 };
 
@@ -0,0 +1,220 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <type_traits>
+
+#include <immintrin.h>
+
+#include "TestTools.hpp"
+#include "BitSlice.hpp"
+
+// Thousands of independent x(n + 2) = x(n + 1) + x(n)(mod 2^Bits) sequences,
+// bit-sliced versus one sequence per SIMD lane, in billions of
+// sequence-steps per second
+//
+// The lane kernels do not care about Bits, they just throw away the high bits
+// at the end. "Narrow" uses the smallest lane that still holds Bits bits.
+
+constexpr std::size_t Sequences = 8192;
+constexpr std::size_t Steps = 4096;
+
+// One sequence per lane, for 8, 16, and 32-bit lanes
+template< typename LaneT >
+struct LaneKernel;
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+using LaneVector = __m512i;
+inline LaneVector LoadLanes( const void* Source ) { return _mm512_loadu_si512(Source); }
+inline void StoreLanes( void* Destination, LaneVector A ) { _mm512_storeu_si512(Destination, A); }
+template<> struct LaneKernel<std::uint8_t>  { static LaneVector Add( LaneVector A, LaneVector B ) { return _mm512_add_epi8(A, B); } };
+template<> struct LaneKernel<std::uint16_t> { static LaneVector Add( LaneVector A, LaneVector B ) { return _mm512_add_epi16(A, B); } };
+template<> struct LaneKernel<std::uint32_t> { static LaneVector Add( LaneVector A, LaneVector B ) { return _mm512_add_epi32(A, B); } };
+#else
+using LaneVector = __m256i;
+inline LaneVector LoadLanes( const void* Source ) { return _mm256_loadu_si256(static_cast<const __m256i*>(Source)); }
+inline void StoreLanes( void* Destination, LaneVector A ) { _mm256_storeu_si256(static_cast<__m256i*>(Destination), A); }
+template<> struct LaneKernel<std::uint8_t>  { static LaneVector Add( LaneVector A, LaneVector B ) { return _mm256_add_epi8(A, B); } };
+template<> struct LaneKernel<std::uint16_t> { static LaneVector Add( LaneVector A, LaneVector B ) { return _mm256_add_epi16(A, B); } };
+template<> struct LaneKernel<std::uint32_t> { static LaneVector Add( LaneVector A, LaneVector B ) { return _mm256_add_epi32(A, B); } };
+#endif
+
+// Steps every sequence, four vectors at a time to keep the adders busy
+template< typename LaneT >
+void StepLanes( LaneT* Term, LaneT* Next, std::size_t Count )
+{
+	constexpr std::size_t PerVector = sizeof(LaneVector) / sizeof(LaneT);
+	const auto Add = LaneKernel<LaneT>::Add;
+	for( std::size_t i = 0; i < Sequences; i += PerVector * 4 )
+	{
+		LaneVector A0 = LoadLanes(Term + i + PerVector * 0);
+		LaneVector A1 = LoadLanes(Term + i + PerVector * 1);
+		LaneVector A2 = LoadLanes(Term + i + PerVector * 2);
+		LaneVector A3 = LoadLanes(Term + i + PerVector * 3);
+		LaneVector B0 = LoadLanes(Next + i + PerVector * 0);
+		LaneVector B1 = LoadLanes(Next + i + PerVector * 1);
+		LaneVector B2 = LoadLanes(Next + i + PerVector * 2);
+		LaneVector B3 = LoadLanes(Next + i + PerVector * 3);
+		for( std::size_t Step = 0; Step < Count; Step += 2 )
+		{
+			A0 = Add(A0, B0); A1 = Add(A1, B1); A2 = Add(A2, B2); A3 = Add(A3, B3);
+			B0 = Add(A0, B0); B1 = Add(A1, B1); B2 = Add(A2, B2); B3 = Add(A3, B3);
+		}
+		StoreLanes(Term + i + PerVector * 0, A0);
+		StoreLanes(Term + i + PerVector * 1, A1);
+		StoreLanes(Term + i + PerVector * 2, A2);
+		StoreLanes(Term + i + PerVector * 3, A3);
+		StoreLanes(Next + i + PerVector * 0, B0);
+		StoreLanes(Next + i + PerVector * 1, B1);
+		StoreLanes(Next + i + PerVector * 2, B2);
+		StoreLanes(Next + i + PerVector * 3, B3);
+	}
+}
+
+// Smallest lane that holds Bits bits
+template< std::size_t Bits >
+using NarrowLane = typename std::conditional<
+	Bits <= 8, std::uint8_t,
+	typename std::conditional<Bits <= 16, std::uint16_t, std::uint32_t>::type
+>::type;
+
+template< typename FunctionT >
+double StepsPerNs( FunctionT&& Function )
+{
+	return 1.0 / Bench<>::BestPerItem(Function, double(Sequences) * Steps);
+}
+
+#define ColumnWidth 14
+
+template< std::size_t Bits >
+bool Row( const std::vector<std::uint32_t>& Seed0, const std::vector<std::uint32_t>& Seed1 )
+{
+	using Engine = BitSlicedFib<Bits>;
+	const std::uint32_t Mask = Bits == 32 ? ~0u : (1u << Bits) - 1;
+
+	// Reference, including an odd number of steps
+	bool Passed = true;
+	for( const std::size_t Count : { std::size_t(0), std::size_t(1), std::size_t(1001) } )
+	{
+		std::vector<std::uint32_t> Results(Sequences);
+		for( std::size_t i = 0; i < Sequences; i += Engine::Lanes )
+		{
+			Engine Sliced(Seed0.data() + i, Seed1.data() + i);
+			Sliced.Step(Count);
+			Sliced.Get(Results.data() + i);
+		}
+		for( std::size_t i = 0; i < Sequences; ++i )
+		{
+			std::uint32_t Term = Seed0[i], Next = Seed1[i];
+			for( std::size_t Step = 0; Step < Count; ++Step )
+			{
+				const std::uint32_t Sum = Term + Next;
+				Term = Next;
+				Next = Sum;
+			}
+			Passed &= Results[i] == (Term & Mask);
+		}
+	}
+
+	std::vector<std::uint32_t> Term32(Seed0), Next32(Seed1);
+	const double Lanes32 = StepsPerNs(
+		[&]() -> int
+		{
+			StepLanes(Term32.data(), Next32.data(), Steps);
+			return 0;
+		}
+	);
+
+	using LaneT = NarrowLane<Bits>;
+	std::vector<LaneT> TermNarrow(Seed0.begin(), Seed0.end()), NextNarrow(Seed1.begin(), Seed1.end());
+	const double LanesNarrow = StepsPerNs(
+		[&]() -> int
+		{
+			StepLanes(TermNarrow.data(), NextNarrow.data(), Steps);
+			return 0;
+		}
+	);
+
+	// Including the transposes in and out of bit planes
+	std::vector<std::uint32_t> Results(Sequences);
+	const double Sliced = StepsPerNs(
+		[&]() -> int
+		{
+			for( std::size_t i = 0; i < Sequences; i += Engine::Lanes )
+			{
+				Engine Sliced(Seed0.data() + i, Seed1.data() + i);
+				Sliced.Step(Steps);
+				Sliced.Get(Results.data() + i);
+			}
+			return 0;
+		}
+	);
+
+	// Cost of getting values back out, for consumers that need every term
+	const Engine Single(Seed0.data(), Seed1.data());
+	const double GetNs = Bench<>::BestPerItem(
+		[&]() -> int
+		{
+			for( std::size_t Round = 0; Round < 256; ++Round )
+			{
+				Single.Get(Results.data());
+			}
+			return 0;
+		},
+		256.0 * Engine::Lanes
+	);
+
+	std::cout
+		<< std::setw(ColumnWidth) << Bits
+		<< std::setw(ColumnWidth) << Lanes32
+		<< std::setw(ColumnWidth - 5) << LanesNarrow << "(u" << std::setw(2) << sizeof(LaneT) * 8 << ")"
+		<< std::setw(ColumnWidth) << Sliced
+		<< std::setw(ColumnWidth) << Sliced / Lanes32
+		<< std::setw(ColumnWidth) << GetNs
+		<< std::setw(ColumnWidth - 1) << ' '
+		<< (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+	return Passed;
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	std::mt19937 Random(0);
+	std::vector<std::uint32_t> Seed0(Sequences), Seed1(Sequences);
+	for( std::size_t i = 0; i < Sequences; ++i )
+	{
+		Seed0[i] = Random();
+		Seed1[i] = Random();
+	}
+
+	std::cout
+		<< Sequences << " sequences, " << Steps << " steps, "
+		<< BitSlicedFib<1>::Lanes << " per bit-sliced batch\n"
+		<< std::setw(ColumnWidth) << "Bits"
+		<< std::setw(ColumnWidth) << "Lanes"
+		<< std::setw(ColumnWidth) << "Narrow"
+		<< std::setw(ColumnWidth) << "Bit-sliced"
+		<< std::setw(ColumnWidth) << "Speedup"
+		<< std::setw(ColumnWidth) << "Get(ns)"
+		<< std::setw(ColumnWidth) << "Valid" << std::endl;
+
+	bool Passed = true;
+	Passed &= Row<1>(Seed0, Seed1);
+	Passed &= Row<2>(Seed0, Seed1);
+	Passed &= Row<4>(Seed0, Seed1);
+	Passed &= Row<6>(Seed0, Seed1);
+	Passed &= Row<8>(Seed0, Seed1);
+	Passed &= Row<12>(Seed0, Seed1);
+	Passed &= Row<16>(Seed0, Seed1);
+	Passed &= Row<24>(Seed0, Seed1);
+	Passed &= Row<32>(Seed0, Seed1);
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,189 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <exception>
+#include <stdexcept>
+
+#include <unistd.h>
+
+#include "TestTools.hpp"
+#include "BigUInt.hpp"
+#include "Checkpoint.hpp"
+
+// Exact F(n) from scratch versus from the closest memory-mapped checkpoint
+//
+// Usage: checkpoint [Path]
+// Without a Path, a store is built in /tmp first, as ckptbuild would, and
+// removed again afterwards
+
+using MsBench = Bench<std::chrono::duration<double, std::milli>>;
+
+// Exact, below, on, between, and past the checkpoints
+bool CheckStore( const CheckpointStore& Store )
+{
+	const std::uint64_t Last = Store[Store.Size() - 1].Index;
+	std::mt19937_64 Random(0);
+	std::uniform_int_distribution<std::uint64_t> Index(0, Last + Last / 8);
+	std::vector<std::uint64_t> Checked = { 0, 1, 2, Store[0].Index - 1, Store[0].Index, Store[0].Index + 1, Last, Last + 1 };
+	for( std::size_t i = 0; i < 24; ++i )
+	{
+		Checked.push_back(Index(Random));
+	}
+	bool Passed = true;
+	for( const std::uint64_t n : Checked )
+	{
+		const std::pair<BigUInt, BigUInt> Pair = Store.FibPair(n);
+		const std::pair<BigUInt, BigUInt> Expected = FibBigPair(n);
+		Passed &= Pair.first == Expected.first && Pair.second == Expected.second;
+	}
+	return Passed;
+}
+
+#define ColumnWidth 14
+
+int main( int argc, char* argv[] )
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(3);
+	bool Passed = true;
+
+	// A store of its own per run, removed again at the end
+	std::string Path = "/tmp/qfib-checkpoint-" + std::to_string(::getpid()) + ".ckpt";
+	const bool Owned = argc < 2;
+	if( !Owned )
+	{
+		Path = argv[1];
+	}
+	else
+	{
+		WriteCheckpoints(Path, CheckpointIndices(300000, 3000));
+	}
+
+	const double OpenMs = MsBench::BestOf(
+		[&]() -> std::size_t
+		{
+			const CheckpointStore Store(Path);
+			return Store.Size();
+		}
+	).count();
+
+	const CheckpointStore Store(Path);
+	if( !Store.Size() )
+	{
+		std::cerr << Path << " holds no checkpoints" << std::endl;
+		if( Owned )
+		{
+			std::remove(Path.c_str());
+		}
+		return EXIT_FAILURE;
+	}
+	const std::uint64_t Last = Store[Store.Size() - 1].Index;
+	std::cout
+		<< Store.Size() << " checkpoints up to F(" << Last << "), mapped in "
+		<< OpenMs << "ms" << std::endl;
+
+	Passed &= CheckStore(Store);
+
+	// Geometric spacing, each checkpoint at least half again past the last
+	{
+		const std::string Geometric = Path + ".geometric";
+		const std::vector<std::uint64_t> Indices = CheckpointIndices(300000, 1000, 1.5);
+		WriteCheckpoints(Geometric, Indices);
+		const CheckpointStore Spread(Geometric);
+		bool Valid = Spread.Size() == Indices.size() && CheckStore(Spread);
+		for( std::size_t i = 1; i < Indices.size(); ++i )
+		{
+			Valid &= Indices[i] >= Indices[i - 1] + Indices[i - 1] / 2;
+		}
+		std::remove(Geometric.c_str());
+		// Growth far beyond 64 bits just ends the run
+		Valid &= CheckpointIndices(~0ULL, 1000, 1e300) == std::vector<std::uint64_t>{ 1000 };
+		std::cout << Indices.size() << " geometric checkpoints up to F(" << Indices.back() << ")" << std::endl;
+		Passed &= Valid;
+	}
+
+	// A repeated index would write a file the store refuses to open
+	{
+		const std::string Repeated = Path + ".repeated";
+		bool Rejected = false;
+		try
+		{
+			WriteCheckpoints(Repeated, { 0, 100, 100, 200 });
+		}
+		catch( const std::invalid_argument& )
+		{
+			Rejected = true;
+		}
+		std::remove(Repeated.c_str());
+		Passed &= Rejected;
+	}
+
+	// Anything that is not a checkpoint file is turned away
+	{
+		const std::string Broken = Path + ".broken";
+		std::ifstream Source(Path, std::ios::binary);
+		std::ofstream Truncated(Broken, std::ios::binary | std::ios::trunc);
+		std::vector<char> Head(sizeof(CheckpointHeader) + sizeof(CheckpointEntry) + 1);
+		Source.read(Head.data(), Head.size());
+		Truncated.write(Head.data(), Source.gcount());
+		Truncated.close();
+		bool Rejected = false;
+		try
+		{
+			const CheckpointStore Invalid(Broken);
+		}
+		catch( const std::exception& )
+		{
+			Rejected = true;
+		}
+		std::remove(Broken.c_str());
+		Passed &= Rejected;
+	}
+
+	std::cout
+		<< std::setw(ColumnWidth) << "n"
+		<< std::setw(ColumnWidth) << "Distance"
+		<< std::setw(ColumnWidth) << "Scratch(ms)"
+		<< std::setw(ColumnWidth) << "Store(ms)"
+		<< std::setw(ColumnWidth) << "Speedup" << std::endl;
+	for( const std::uint64_t n : { Last / 8 + 1234, Last / 4 + 567, Last / 2 + 1, Last - 1 } )
+	{
+		const double Scratch = MsBench::BestOf(
+			[&]() -> std::size_t
+			{
+				return FibBig(n).Limb.size();
+			},
+			3
+		).count();
+		const double FromStore = MsBench::BestOf(
+			[&]() -> std::size_t
+			{
+				return Store.Fib(n).Limb.size();
+			},
+			3
+		).count();
+		std::cout
+			<< std::setw(ColumnWidth) << n
+			<< std::setw(ColumnWidth) << n - Store.Nearest(n)->Index
+			<< std::setw(ColumnWidth) << Scratch
+			<< std::setw(ColumnWidth) << FromStore
+			<< std::setw(ColumnWidth) << Scratch / FromStore << std::endl;
+	}
+
+	if( Owned )
+	{
+		std::remove(Path.c_str());
+	}
+	std::cout << (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,59 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <exception>
+
+#include "Checkpoint.hpp"
+
+// Builds a checkpoint file of exact F(k), F(k + 1) for CheckpointStore
+//
+// Usage: ckptbuild [Path] [MaxIndex] [Stride] [Growth]
+// With a Growth above 1 the gaps between checkpoints widen geometrically
+
+int main( int argc, char* argv[] )
+{
+	const std::string Path       = argc > 1 ? argv[1] : "/tmp/qfib.ckpt";
+	const std::uint64_t MaxIndex = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000000;
+	const std::uint64_t Stride   = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 10000;
+	const double Growth          = argc > 4 ? std::strtod(argv[4], nullptr) : 1.0;
+	if( !std::isfinite(Growth) || Growth < 1.0 )
+	{
+		std::cerr << "Growth must be a finite number of at least 1" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	const std::vector<std::uint64_t> Indices = CheckpointIndices(MaxIndex, Stride, Growth);
+	const auto Start = std::chrono::steady_clock::now();
+	try
+	{
+		WriteCheckpoints(Path, Indices);
+	}
+	catch( const std::exception& Error )
+	{
+		std::cerr << Error.what() << std::endl;
+		return EXIT_FAILURE;
+	}
+	const std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+
+	const CheckpointStore Store(Path);
+	std::uint64_t Limbs = 0;
+	for( std::size_t i = 0; i < Store.Size(); ++i )
+	{
+		Limbs += Store[i].Limbs0 + Store[i].Limbs1;
+	}
+	std::cout
+		<< std::fixed << std::setprecision(2)
+		<< "Wrote " << Store.Size() << " checkpoints up to F("
+		<< (Store.Size() ? Store[Store.Size() - 1].Index : 0) << ") to " << Path << ", "
+		<< Limbs * sizeof(std::uint64_t) / (1024.0 * 1024.0) << "MiB in "
+		<< Elapsed.count() << "s" << std::endl;
+	return EXIT_SUCCESS;
+}
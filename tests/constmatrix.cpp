@@ -0,0 +1,193 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <array>
+
+#include "TestTools.hpp"
+#include "FibKernels.hpp"
+#include "ConstMatrix.hpp"
+
+// Checks ConstMatrix products against plain multiplication, and
+// FibNextState against FibPair and the hand-written kernels, for scalar
+// and vector register elements
+
+// Coefficients with several set bits, to cover more than single shifts
+using Mixed = ConstMatrix<
+	3, 2,
+	0,   3,
+	5,   7,
+	255, 1
+>;
+
+template< typename T >
+bool CheckMixed( T a, T b )
+{
+	const std::array<T, 3> Product = Mixed::Multiply(std::array<T, 2>{{ a, b }});
+	return
+		Product[0] == static_cast<T>(3 * b)
+		&& Product[1] == static_cast<T>(5 * a + 7 * b)
+		&& Product[2] == static_cast<T>(255 * a + b);
+}
+
+// State { F(n + 3), F(n + 2), F(n + 1), F(n) } as FibNextState expects it
+template< typename T >
+std::array<T, 4> ScalarState( std::uint64_t n )
+{
+	const auto Pair = FibPair<T>(n);
+	const T Term2 = Pair.first + Pair.second;
+	return {{ static_cast<T>(Pair.second + Term2), Term2, Pair.second, Pair.first }};
+}
+
+// Scalar elements, stepped 64 times from n against FibPair
+template< typename T >
+bool CheckScalar( std::uint64_t n )
+{
+	bool Passed = true;
+	std::array<T, 4> State = ScalarState<T>(n);
+	for( std::size_t Step = 1; Step <= 64; ++Step )
+	{
+		State = FibNextState::Multiply(State);
+		Passed &= State == ScalarState<T>(n + 4 * Step);
+	}
+	return Passed;
+}
+
+// Four independent sequences, one per lane, against FibPair
+// Element k of the state holds F(n_j + 3 - k) in lane j
+bool CheckU32x4( const std::uint64_t (&n)[4] )
+{
+	bool Passed = true;
+	std::array<U32x4, 4> State;
+	for( std::size_t k = 0; k < 4; ++k )
+	{
+		State[k].Lanes = _mm_set_epi32(
+			static_cast<int>(ScalarState<std::uint32_t>(n[3])[k]),
+			static_cast<int>(ScalarState<std::uint32_t>(n[2])[k]),
+			static_cast<int>(ScalarState<std::uint32_t>(n[1])[k]),
+			static_cast<int>(ScalarState<std::uint32_t>(n[0])[k])
+		);
+	}
+	for( std::size_t Step = 1; Step <= 64; ++Step )
+	{
+		State = FibNextState::Multiply(State);
+		for( std::size_t j = 0; j < 4; ++j )
+		{
+			const std::array<std::uint32_t, 4> Expected = ScalarState<std::uint32_t>(n[j] + 4 * Step);
+			for( std::size_t k = 0; k < 4; ++k )
+			{
+				alignas(16) std::uint32_t Lanes[4];
+				_mm_store_si128(reinterpret_cast<__m128i*>(Lanes), State[k].Lanes);
+				Passed &= Lanes[j] == Expected[k];
+			}
+		}
+	}
+	return Passed;
+}
+
+bool CheckU64x4( const std::uint64_t (&n)[4] )
+{
+	bool Passed = true;
+	std::array<U64x4, 4> State;
+	for( std::size_t k = 0; k < 4; ++k )
+	{
+		State[k].Lanes = _mm256_set_epi64x(
+			static_cast<long long>(ScalarState<std::uint64_t>(n[3])[k]),
+			static_cast<long long>(ScalarState<std::uint64_t>(n[2])[k]),
+			static_cast<long long>(ScalarState<std::uint64_t>(n[1])[k]),
+			static_cast<long long>(ScalarState<std::uint64_t>(n[0])[k])
+		);
+	}
+	for( std::size_t Step = 1; Step <= 64; ++Step )
+	{
+		State = FibNextState::Multiply(State);
+		for( std::size_t j = 0; j < 4; ++j )
+		{
+			const std::array<std::uint64_t, 4> Expected = ScalarState<std::uint64_t>(n[j] + 4 * Step);
+			for( std::size_t k = 0; k < 4; ++k )
+			{
+				alignas(32) std::uint64_t Lanes[4];
+				_mm256_store_si256(reinterpret_cast<__m256i*>(Lanes), State[k].Lanes);
+				Passed &= Lanes[j] == Expected[k];
+			}
+		}
+	}
+	return Passed;
+}
+
+// The same step as FibNext4 and FibNext4x64, whose registers hold the
+// state lowest term first
+bool CheckKernels( std::uint64_t n )
+{
+	bool Passed = true;
+	std::array<std::uint32_t, 4> State32 = ScalarState<std::uint32_t>(n);
+	std::array<std::uint64_t, 4> State64 = ScalarState<std::uint64_t>(n);
+	__m128i Kernel32 = _mm_set_epi32(
+		static_cast<int>(State32[0]), static_cast<int>(State32[1]),
+		static_cast<int>(State32[2]), static_cast<int>(State32[3])
+	);
+	__m256i Kernel64 = FibState4x64(n);
+	for( std::size_t Step = 1; Step <= 64; ++Step )
+	{
+		State32 = FibNextState::Multiply(State32);
+		State64 = FibNextState::Multiply(State64);
+		Kernel32 = FibNext4(Kernel32);
+		Kernel64 = FibNext4x64(Kernel64);
+		alignas(16) std::uint32_t Lanes32[4];
+		alignas(32) std::uint64_t Lanes64[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(Lanes32), Kernel32);
+		_mm256_store_si256(reinterpret_cast<__m256i*>(Lanes64), Kernel64);
+		for( std::size_t k = 0; k < 4; ++k )
+		{
+			Passed &= Lanes32[k] == State32[3 - k];
+			Passed &= Lanes64[k] == State64[3 - k];
+		}
+	}
+	return Passed;
+}
+
+void Report( const char* Name, bool Passed )
+{
+	std::cout
+		<< Name << ' '
+		<< (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+}
+
+int main()
+{
+	bool Passed = true;
+
+	bool Coefficients = true;
+	for( const std::uint64_t a : { 0ULL, 1ULL, 12345ULL, 0xFFFFFFFFULL, 0xDEADBEEFCAFEF00DULL } )
+	{
+		for( const std::uint64_t b : { 0ULL, 7ULL, 0x80000000ULL, ~0ULL } )
+		{
+			Coefficients &= CheckMixed<std::uint32_t>(static_cast<std::uint32_t>(a), static_cast<std::uint32_t>(b));
+			Coefficients &= CheckMixed<std::uint64_t>(a, b);
+		}
+	}
+	Report("Mixed coefficients", Coefficients);
+	Passed &= Coefficients;
+
+	bool Scalar = true;
+	bool Kernels = true;
+	for( const std::uint64_t n : { 0ULL, 1ULL, 93ULL, 1000003ULL, 1ULL << 40 } )
+	{
+		Scalar &= CheckScalar<std::uint32_t>(n) && CheckScalar<std::uint64_t>(n);
+		Kernels &= CheckKernels(n);
+	}
+	Report("Scalar", Scalar);
+	Report("FibNext4 / FibNext4x64", Kernels);
+	Passed &= Scalar && Kernels;
+
+	const std::uint64_t Starts[4] = { 0, 5, 1000, 1ULL << 50 };
+	const bool Vector32 = CheckU32x4(Starts);
+	const bool Vector64 = CheckU64x4(Starts);
+	Report("U32x4", Vector32);
+	Report("U64x4", Vector64);
+	Passed &= Vector32 && Vector64;
+
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
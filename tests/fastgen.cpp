@@ -16,6 +16,8 @@
 #include <immintrin.h>
 
 #include "Bench.hpp"
+#include "FibKernels.hpp"
+#include "ConstMatrix.hpp"
 
 using VectorT = glm::vec<4, glm::u32,glm::qualifier::packed_highp>;
 using MatrixT = glm::mat<4, 4, glm::u32,glm::qualifier::packed_highp>;
@@ -65,28 +67,11 @@ void MatrixSIMD()
 	   << std::setw(8) << 2 << ':' << std::setw(32) << _mm_extract_epi32(FibState,2) << '\n'
 	   << std::setw(8) << 3 << ':' << std::setw(32) << _mm_extract_epi32(FibState,3) << '\n';
 
-	const __m128i NextState[3] = {
-		//_mm_set_epi32(~0, ~0, ~0, ~0), same as multiplying vector by <0>
-		_mm_set_epi32( 0,  1, ~0, ~0),
-		_mm_set_epi32( 2,  2,  0,  0),
-		_mm_set_epi32( 2,  0,  1,  0)
-	};
-
 	for( std::size_t i = 0; i < 300; i += 4 )
 	{
 		const auto Start = std::chrono::high_resolution_clock::now();
-		__m128i Result = _mm_setzero_si128();
-		FibState = _mm_alignr_epi8(FibState, FibState, 4);
-		for( std::size_t i = 0; i < 3; ++i )
-		{
-			const __m128i Product = _mm_sllv_epi32(
-				_mm_broadcastd_epi32(FibState), NextState[i]
-			);
-			FibState = _mm_alignr_epi8(_mm_setzero_si128(), FibState, 4);
-			Result = _mm_add_epi32(Result, Product);
-		}
+		FibState = FibNext4(FibState);
 		const auto Stop = std::chrono::high_resolution_clock::now();
-		FibState = Result;
 		std::cout
 			<< (Stop - Start).count() << "ns |\n"
 			<< std::setw(8) << (i + 0) << ':' << std::setw(32) << (std::uint32_t)_mm_extract_epi32(FibState,0) << '\n'
@@ -96,12 +81,40 @@ void MatrixSIMD()
 	}
 }
 
+// Same matrix as Matrix(), with the coefficients baked into the type so that
+// the product compiles down to shifts and adds
+void MatrixConst()
+{
+	std::array<std::uint32_t, 4> FibState = {{ 2, 1, 1, 0 }};
+
+	std::cout
+	   << std::setw(8) << 0 << ':' << std::setw(32) << FibState[3] << '\n'
+	   << std::setw(8) << 1 << ':' << std::setw(32) << FibState[2] << '\n'
+	   << std::setw(8) << 2 << ':' << std::setw(32) << FibState[1] << '\n'
+	   << std::setw(8) << 3 << ':' << std::setw(32) << FibState[0] << '\n';
+
+	for( std::size_t i = 0; i < 300; i += 4 )
+	{
+		const auto Start = std::chrono::high_resolution_clock::now();
+		FibState = FibNextState::Multiply(FibState);
+		const auto Stop = std::chrono::high_resolution_clock::now();
+		std::cout
+			<< (Stop - Start).count() << "ns |\n"
+			<< std::setw(8) << (i + 0) << ':' << std::setw(32) << FibState[3] << '\n'
+			<< std::setw(8) << (i + 1) << ':' << std::setw(32) << FibState[2] << '\n'
+			<< std::setw(8) << (i + 2) << ':' << std::setw(32) << FibState[1] << '\n'
+			<< std::setw(8) << (i + 3) << ':' << std::setw(32) << FibState[0] << '\n';
+	}
+}
+
 int main()
 {
 	std::cout << std::fixed << std::setprecision(2);
 	Matrix();
 	std::puts("---------");
 	MatrixSIMD();
+	std::puts("---------");
+	MatrixConst();
 
 	return EXIT_SUCCESS;
 }
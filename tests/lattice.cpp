@@ -0,0 +1,325 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+#include <chrono>
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <stdexcept>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+#include "TestTools.hpp"
+#include "FibKernels.hpp"
+#include "FibLattice.hpp"
+
+// Fibonacci lattice and golden-angle sphere point sets, SIMD and threaded
+// against a scalar loop of the same index arithmetic, in millions of points
+// per second
+
+#define ColumnWidth 14
+
+template< typename FunctionT >
+double PointsPerUs( FunctionT&& Function, std::uint64_t Points )
+{
+	return 1000.0 / Bench<>::BestPerItem(Function, static_cast<double>(Points));
+}
+
+void ScalarLattice2D( std::size_t m, double* X, double* Y )
+{
+	const auto Pair = FibPair<std::uint64_t>(m - 1);
+	const std::uint64_t Previous = Pair.first, Points = Pair.second;
+	const double Scale = 1.0 / static_cast<double>(Points);
+	std::uint64_t Row = 0;
+	for( std::uint64_t i = 0; i < Points; ++i )
+	{
+		X[i] = static_cast<double>(i) * Scale;
+		Y[i] = static_cast<double>(Row) * Scale;
+		Row += Previous;
+		Row -= Row >= Points ? Points : 0;
+	}
+}
+
+void ScalarSphere( std::uint64_t N, double* X, double* Y, double* Z )
+{
+	const double TwoPi = 6.283185307179586;
+	std::uint64_t Turn = 0;
+	for( std::uint64_t i = 0; i < N; ++i )
+	{
+		const double z = 1.0 - (2.0 * static_cast<double>(i) + 1.0) / static_cast<double>(N);
+		const double Radius = std::sqrt((1.0 - z) * (1.0 + z));
+		const double Angle = TwoPi * static_cast<double>(Turn >> 12) / 4503599627370496.0;
+		X[i] = Radius * std::cos(Angle);
+		Y[i] = Radius * std::sin(Angle);
+		Z[i] = z;
+		Turn += FibLatticeImpl::GoldenTurn;
+	}
+}
+
+double MaxError( const std::vector<double>& A, const std::vector<double>& B )
+{
+	double Error = 0.0;
+	for( std::size_t i = 0; i < A.size(); ++i )
+	{
+		Error = std::max(Error, std::abs(A[i] - B[i]));
+	}
+	return Error;
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	bool Passed = true;
+	const std::size_t Threads = std::max(1u, std::thread::hardware_concurrency());
+
+	std::cout
+		<< "Million points per second, " << Threads << " threads\n"
+		<< std::setw(ColumnWidth) << "Set"
+		<< std::setw(ColumnWidth) << "Points"
+		<< std::setw(ColumnWidth) << "Scalar"
+		<< std::setw(ColumnWidth) << "SoA"
+		<< std::setw(ColumnWidth) << "AoS"
+		<< std::setw(ColumnWidth) << "Threads"
+		<< std::setw(ColumnWidth) << "Error"
+		<< std::setw(ColumnWidth) << "Valid" << std::endl;
+
+	{
+		constexpr std::size_t m = 30;
+		const FibLattice2D Lattice(m);
+		const std::uint64_t N = Lattice.Size();
+		std::vector<double> X(N), Y(N), ExpectedX(N), ExpectedY(N), XY(2 * N);
+		ScalarLattice2D(m, ExpectedX.data(), ExpectedY.data());
+
+		// Every alignment of the start and the tail, then the whole set
+		bool Valid = true;
+		for( std::uint64_t First = 0; First < 9; ++First )
+		{
+			const std::size_t Count = 1000 + First;
+			Lattice.Generate(First, Count, X.data(), Y.data());
+			Lattice.Generate(First, Count, XY.data());
+			for( std::size_t i = 0; i < Count; ++i )
+			{
+				Valid &= X[i] == ExpectedX[First + i] && Y[i] == ExpectedY[First + i];
+				Valid &= XY[2 * i] == ExpectedX[First + i] && XY[2 * i + 1] == ExpectedY[First + i];
+			}
+		}
+
+		// Arrays at different offsets within a vector, which no one split can
+		// align together, and nothing past the end of the set
+		for( std::size_t Shift = 1; Shift < 8; ++Shift )
+		{
+			Lattice.Generate(3, 1000, X.data(), Y.data() + Shift);
+			for( std::size_t i = 0; i < 1000; ++i )
+			{
+				Valid &= X[i] == ExpectedX[3 + i] && Y[Shift + i] == ExpectedY[3 + i];
+			}
+		}
+		bool Rejected = false;
+		try
+		{
+			Lattice.Generate(N - 3, 4, X.data(), Y.data());
+		}
+		catch( const std::out_of_range& )
+		{
+			Rejected = true;
+		}
+		Valid &= Rejected;
+
+		const double Scalar = PointsPerUs(
+			[&]() -> int
+			{
+				ScalarLattice2D(m, X.data(), Y.data());
+				return 0;
+			},
+			N
+		);
+		const double SoA = PointsPerUs(
+			[&]() -> int
+			{
+				Lattice.Generate(0, N, X.data(), Y.data());
+				return 0;
+			},
+			N
+		);
+		Valid &= X == ExpectedX && Y == ExpectedY;
+		const double AoS = PointsPerUs(
+			[&]() -> int
+			{
+				Lattice.Generate(0, N, XY.data());
+				return 0;
+			},
+			N
+		);
+		const double Parallel = PointsPerUs(
+			[&]() -> int
+			{
+				FibParallelRanges(
+					0, N, Threads,
+					[&]( std::uint64_t First, std::uint64_t Count )
+					{
+						Lattice.Generate(First, Count, X.data() + First, Y.data() + First);
+					}
+				);
+				return 0;
+			},
+			N
+		);
+		Valid &= X == ExpectedX && Y == ExpectedY;
+
+		std::cout
+			<< std::setw(ColumnWidth) << "Lattice F(30)"
+			<< std::setw(ColumnWidth) << N
+			<< std::setw(ColumnWidth) << Scalar
+			<< std::setw(ColumnWidth) << SoA
+			<< std::setw(ColumnWidth) << AoS
+			<< std::setw(ColumnWidth) << Parallel
+			<< std::setw(ColumnWidth) << std::scientific << 0.0 << std::fixed
+			<< std::setw(ColumnWidth - 1) << ' '
+			<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+		Passed &= Valid;
+	}
+
+	{
+		constexpr std::uint64_t N = 1 << 20;
+		const FibSphere Sphere(N);
+		std::vector<double> X(N), Y(N), Z(N), ExpectedX(N), ExpectedY(N), ExpectedZ(N), XYZ(3 * N);
+		ScalarSphere(N, ExpectedX.data(), ExpectedY.data(), ExpectedZ.data());
+
+		bool Valid = true;
+		for( std::uint64_t First = 0; First < 9; ++First )
+		{
+			const std::size_t Count = 1000 + First;
+			Sphere.Generate(First, Count, X.data(), Y.data(), Z.data());
+			Sphere.Generate(First, Count, XYZ.data());
+			for( std::size_t i = 0; i < Count; ++i )
+			{
+				Valid &= std::abs(X[i] - ExpectedX[First + i]) < 1e-14;
+				Valid &= std::abs(Y[i] - ExpectedY[First + i]) < 1e-14;
+				Valid &= std::abs(Z[i] - ExpectedZ[First + i]) < 1e-14;
+				Valid &= XYZ[3 * i] == X[i] && XYZ[3 * i + 1] == Y[i] && XYZ[3 * i + 2] == Z[i];
+			}
+		}
+
+		for( std::size_t Shift = 1; Shift < 8; ++Shift )
+		{
+			Sphere.Generate(3, 1000, X.data(), Y.data() + Shift, Z.data() + 2 * Shift);
+			for( std::size_t i = 0; i < 1000; ++i )
+			{
+				Valid &= std::abs(X[i] - ExpectedX[3 + i]) < 1e-14;
+				Valid &= std::abs(Y[Shift + i] - ExpectedY[3 + i]) < 1e-14;
+				Valid &= std::abs(Z[2 * Shift + i] - ExpectedZ[3 + i]) < 1e-14;
+			}
+		}
+		bool Rejected = false;
+		try
+		{
+			Sphere.Generate(N, 1, XYZ.data());
+		}
+		catch( const std::out_of_range& )
+		{
+			Rejected = true;
+		}
+		Valid &= Rejected;
+
+		const double Scalar = PointsPerUs(
+			[&]() -> int
+			{
+				ScalarSphere(N, X.data(), Y.data(), Z.data());
+				return 0;
+			},
+			N
+		);
+		const double SoA = PointsPerUs(
+			[&]() -> int
+			{
+				Sphere.Generate(0, N, X.data(), Y.data(), Z.data());
+				return 0;
+			},
+			N
+		);
+		double Error = std::max({ MaxError(X, ExpectedX), MaxError(Y, ExpectedY), MaxError(Z, ExpectedZ) });
+		const double AoS = PointsPerUs(
+			[&]() -> int
+			{
+				Sphere.Generate(0, N, XYZ.data());
+				return 0;
+			},
+			N
+		);
+		for( std::size_t i = 0; i < N; ++i )
+		{
+			Valid &= XYZ[3 * i] == X[i] && XYZ[3 * i + 1] == Y[i] && XYZ[3 * i + 2] == Z[i];
+		}
+		const double Parallel = PointsPerUs(
+			[&]() -> int
+			{
+				FibParallelRanges(
+					0, N, Threads,
+					[&]( std::uint64_t First, std::uint64_t Count )
+					{
+						Sphere.Generate(First, Count, X.data() + First, Y.data() + First, Z.data() + First);
+					}
+				);
+				return 0;
+			},
+			N
+		);
+		Error = std::max({ Error, MaxError(X, ExpectedX), MaxError(Y, ExpectedY), MaxError(Z, ExpectedZ) });
+		Valid &= Error < 1e-14;
+
+		std::cout
+			<< std::setw(ColumnWidth) << "Sphere"
+			<< std::setw(ColumnWidth) << N
+			<< std::setw(ColumnWidth) << Scalar
+			<< std::setw(ColumnWidth) << SoA
+			<< std::setw(ColumnWidth) << AoS
+			<< std::setw(ColumnWidth) << Parallel
+			<< std::setw(ColumnWidth) << std::scientific << Error << std::fixed
+			<< std::setw(ColumnWidth - 1) << ' '
+			<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+		Passed &= Valid;
+	}
+
+	// Far more points than are ever held at once, every one checked to be on
+	// the sphere and the whole set to be balanced about the equator
+	{
+		constexpr std::uint64_t N = 1ULL << 28;
+		constexpr std::size_t BlockPoints = 1 << 16;
+		const FibSphere Sphere(N);
+		std::mutex Lock;
+		double SumZ = 0.0, NormError = 0.0;
+		std::uint64_t Seen = 0;
+		const auto Start = std::chrono::steady_clock::now();
+		FibStreamPoints(
+			Sphere, Threads, BlockPoints,
+			[&]( const FibPointBlock& Block )
+			{
+				double BlockZ = 0.0, BlockError = 0.0;
+				for( std::size_t i = 0; i < Block.Count; ++i )
+				{
+					const double x = Block.Coords[0][i], y = Block.Coords[1][i], z = Block.Coords[2][i];
+					BlockZ += z;
+					BlockError = std::max(BlockError, std::abs(x * x + y * y + z * z - 1.0));
+				}
+				std::lock_guard<std::mutex> Guard(Lock);
+				SumZ += BlockZ;
+				NormError = std::max(NormError, BlockError);
+				Seen += Block.Count;
+			}
+		);
+		const std::chrono::duration<double> Elapsed = std::chrono::steady_clock::now() - Start;
+		const bool Valid = Seen == N && NormError < 1e-14 && std::abs(SumZ) < 1e-6;
+		std::cout
+			<< "Streamed " << N << " sphere points in " << BlockPoints << " point blocks: "
+			<< N / Elapsed.count() / 1e6 << " million per second, "
+			<< std::scientific << NormError << " off the sphere "
+			<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+		Passed &= Valid;
+	}
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
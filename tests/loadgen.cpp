@@ -0,0 +1,317 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <random>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "TestTools.hpp"
+#include "FibServer.hpp"
+
+// Closed-loop load generator for the query server
+//
+// For every combination of batch size and deadline a server is started
+// in-process, then every client keeps Outstanding queries in flight for the
+// duration and measures the latency of each answer. Larger batches raise
+// that to enough queries in flight among all clients to fill one.
+//
+// Usage: loadgen [Clients] [Outstanding] [MillisecondsPerRun]
+
+struct ClientResult
+{
+	std::vector<std::uint32_t> Latencies; // ns
+	bool Passed = true;
+};
+
+void RunClient(
+	const std::string& Path, std::size_t Outstanding,
+	std::chrono::steady_clock::time_point End, std::uint64_t Seed, ClientResult& Result
+)
+{
+	using ClockT = std::chrono::steady_clock;
+	const int Socket = FibSocket::Connect(Path);
+	std::mt19937_64 Random(Seed);
+
+	std::deque<std::pair<FibQuery, ClockT::time_point>> InFlight;
+	std::vector<FibQuery> Send;
+	std::uint64_t NextId = 0;
+	const auto Issue = [&]( std::size_t Count )
+	{
+		Send.clear();
+		const auto Now = ClockT::now();
+		for( std::size_t i = 0; i < Count; ++i )
+		{
+			FibQuery Query;
+			Query.Id = NextId++;
+			Query.n = Random();
+			// One in four queries asks for an arbitrary modulus
+			Query.Modulus = (Random() & 3) ? 0 : (Random() >> 1) | 2;
+			Send.push_back(Query);
+			InFlight.emplace_back(Query, Now);
+		}
+		FibSocket::WriteAll(Socket, Send.data(), Send.size() * sizeof(FibQuery));
+	};
+
+	Issue(Outstanding);
+	FibAnswer Answers[256];
+	std::size_t Partial = 0;
+	while( !InFlight.empty() )
+	{
+		const ssize_t Read = ::read(
+			Socket, reinterpret_cast<char*>(Answers) + Partial, sizeof(Answers) - Partial
+		);
+		if( Read <= 0 )
+		{
+			Result.Passed = false;
+			break;
+		}
+		const auto Now = ClockT::now();
+		const std::size_t Available = Partial + static_cast<std::size_t>(Read);
+		const std::size_t Whole = Available / sizeof(FibAnswer);
+		for( std::size_t i = 0; i < Whole; ++i )
+		{
+			const FibQuery& Query = InFlight.front().first;
+			Result.Latencies.push_back(static_cast<std::uint32_t>(
+				std::chrono::duration_cast<std::chrono::nanoseconds>(
+					Now - InFlight.front().second
+				).count()
+			));
+			Result.Passed &= Answers[i].Id == Query.Id;
+			// Spot-check the answers
+			if( (Query.Id & 63) == 0 )
+			{
+				Result.Passed &= Answers[i].Value == FibMod(Query.n, Query.Modulus);
+			}
+			InFlight.pop_front();
+		}
+		Partial = Available - Whole * sizeof(FibAnswer);
+		std::memmove(
+			Answers, reinterpret_cast<char*>(Answers) + Whole * sizeof(FibAnswer), Partial
+		);
+		// Top back up, until time runs out and the rest drains
+		if( Now < End )
+		{
+			Issue(Whole);
+		}
+	}
+	::close(Socket);
+}
+
+#define ColumnWidth 12
+
+int main( int argc, char* argv[] )
+{
+	const std::size_t Clients     = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8;
+	const std::size_t Outstanding = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 4;
+	const std::uint64_t Duration  = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 500;
+
+	signal(SIGPIPE, SIG_IGN);
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	std::cout
+		<< Clients << " clients\n"
+		<< std::setw(ColumnWidth) << "Batch"
+		<< std::setw(ColumnWidth) << "Deadline"
+		<< std::setw(ColumnWidth) << "In flight"
+		<< std::setw(ColumnWidth) << "kQPS"
+		<< std::setw(ColumnWidth) << "p50(us)"
+		<< std::setw(ColumnWidth) << "p99(us)"
+		<< std::setw(ColumnWidth) << "Avg Batch"
+		<< std::setw(ColumnWidth) << "Valid" << std::endl;
+
+	const std::string Path = "/tmp/qfib-loadgen-" + std::to_string(::getpid()) + ".sock";
+	bool Passed = true;
+	for( const std::size_t MaxBatch : { 1, 8, 32, 128 } )
+	{
+		for( const std::uint64_t Deadline : { 0, 50, 200, 1000 } )
+		{
+			if( MaxBatch == 1 && Deadline )
+			{
+				// A deadline has no effect without batching
+				continue;
+			}
+			// Per client
+			const std::size_t InFlight = std::max<std::size_t>(Outstanding, (MaxBatch + Clients - 1) / Clients);
+			FibServer Server(Path, MaxBatch, std::chrono::microseconds(Deadline));
+			std::atomic<bool> Running(true);
+			std::thread ServerThread([&](){ Server.Run(Running); });
+
+			const auto Start = std::chrono::steady_clock::now();
+			const auto End = Start + std::chrono::milliseconds(Duration);
+			std::vector<ClientResult> Results(Clients);
+			std::vector<std::thread> ClientThreads;
+			for( std::size_t i = 0; i < Clients; ++i )
+			{
+				ClientThreads.emplace_back(
+					RunClient, std::cref(Path), InFlight, End, i + 1, std::ref(Results[i])
+				);
+			}
+			for( auto& Thread : ClientThreads )
+			{
+				Thread.join();
+			}
+			const double Seconds = std::chrono::duration<double>(
+				std::chrono::steady_clock::now() - Start
+			).count();
+			Running.store(false);
+			ServerThread.join();
+
+			std::vector<std::uint32_t> Latencies;
+			bool Valid = true;
+			for( const ClientResult& Result : Results )
+			{
+				Latencies.insert(Latencies.end(), Result.Latencies.begin(), Result.Latencies.end());
+				Valid &= Result.Passed;
+			}
+			const auto Percentile = [&]( double Fraction ) -> double
+			{
+				if( Latencies.empty() )
+				{
+					return 0.0;
+				}
+				auto Nth = Latencies.begin() + static_cast<std::ptrdiff_t>(Fraction * (Latencies.size() - 1));
+				std::nth_element(Latencies.begin(), Nth, Latencies.end());
+				return *Nth / 1000.0;
+			};
+			const FibServerStats& Stats = Server.Stats();
+			std::cout
+				<< std::setw(ColumnWidth) << MaxBatch
+				<< std::setw(ColumnWidth - 2) << Deadline << "us"
+				<< std::setw(ColumnWidth) << InFlight
+				<< std::setw(ColumnWidth) << Latencies.size() / Seconds / 1000.0
+				<< std::setw(ColumnWidth) << Percentile(0.50)
+				<< std::setw(ColumnWidth) << Percentile(0.99)
+				<< std::setw(ColumnWidth) << (Stats.Batches ? double(Stats.Queries) / Stats.Batches : 0.0)
+				<< std::setw(ColumnWidth - 1) << ' '
+				<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m"
+				<< std::endl;
+			Passed &= Valid;
+		}
+	}
+
+	// A client that floods queries and never reads its answers must not hold
+	// up anyone else
+	{
+		FibServer Server(Path, 64, std::chrono::microseconds(100));
+		std::atomic<bool> Running(true);
+		std::thread ServerThread([&](){ Server.Run(Running); });
+
+		const int Stalled = FibSocket::Connect(Path);
+		::fcntl(Stalled, F_SETFL, ::fcntl(Stalled, F_GETFL) | O_NONBLOCK);
+		std::vector<FibQuery> Flood(200000);
+		for( std::size_t i = 0; i < Flood.size(); ++i )
+		{
+			Flood[i] = { i, i, 0 };
+		}
+		// Until everything is sent or the server has stopped taking more
+		const char* Bytes = reinterpret_cast<const char*>(Flood.data());
+		std::size_t Left = Flood.size() * sizeof(FibQuery);
+		while( Left )
+		{
+			const ssize_t Written = ::write(Stalled, Bytes, Left);
+			if( Written > 0 )
+			{
+				Bytes += Written;
+				Left -= static_cast<std::size_t>(Written);
+				continue;
+			}
+			pollfd Wait = { Stalled, POLLOUT, 0 };
+			if( ::poll(&Wait, 1, 100) <= 0 )
+			{
+				break;
+			}
+		}
+
+		const int Socket = FibSocket::Connect(Path);
+		const FibQuery Query = { 1, 1000, 0 };
+		FibSocket::WriteAll(Socket, &Query, sizeof(Query));
+		pollfd Wait = { Socket, POLLIN, 0 };
+		FibAnswer Answer = {};
+		const bool Answered =
+			::poll(&Wait, 1, 2000) > 0
+			&& ::read(Socket, &Answer, sizeof(Answer)) == static_cast<ssize_t>(sizeof(Answer));
+		const bool Valid = Answered && Answer.Id == Query.Id && Answer.Value == FibMod(Query.n, 0);
+		::close(Socket);
+		::close(Stalled);
+		Running.store(false);
+		ServerThread.join();
+
+		std::cout
+			<< "Answered beside a client that never reads "
+			<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+		Passed &= Valid;
+	}
+
+	// A client that shuts down its sending side right after its queries still
+	// gets every answer, and the path is not taken from a running server
+	{
+		FibServer Server(Path, 64, std::chrono::microseconds(1000));
+		std::atomic<bool> Running(true);
+		std::thread ServerThread([&](){ Server.Run(Running); });
+
+		bool Refused = false;
+		try
+		{
+			FibServer Second(Path, 64, std::chrono::microseconds(1000));
+		}
+		catch( const std::system_error& )
+		{
+			Refused = true;
+		}
+
+		const int Socket = FibSocket::Connect(Path);
+		std::vector<FibQuery> Queries(1000);
+		for( std::size_t i = 0; i < Queries.size(); ++i )
+		{
+			Queries[i] = { i, 3 * i, i & 1 ? 0ULL : 1000003ULL };
+		}
+		FibSocket::WriteAll(Socket, Queries.data(), Queries.size() * sizeof(FibQuery));
+		::shutdown(Socket, SHUT_WR);
+		std::vector<FibAnswer> Answers(Queries.size() + 1);
+		// Until the server closes the connection, or gives up on it
+		std::size_t Received = 0;
+		ssize_t Read = -1;
+		pollfd Wait = { Socket, POLLIN, 0 };
+		while(
+			::poll(&Wait, 1, 2000) > 0
+			&& (Read = ::read(
+				Socket, reinterpret_cast<char*>(Answers.data()) + Received,
+				Answers.size() * sizeof(FibAnswer) - Received
+			)) > 0
+		)
+		{
+			Received += static_cast<std::size_t>(Read);
+		}
+		bool Valid = Refused && Read == 0 && Received == Queries.size() * sizeof(FibAnswer);
+		for( std::size_t i = 0; Valid && i < Queries.size(); ++i )
+		{
+			Valid &= Answers[i].Id == i && Answers[i].Value == FibMod(Queries[i].n, Queries[i].Modulus);
+		}
+		::close(Socket);
+		Running.store(false);
+		ServerThread.join();
+
+		std::cout
+			<< "Answered after the client stopped sending "
+			<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+		Passed &= Valid;
+	}
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
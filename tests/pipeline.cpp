@@ -0,0 +1,162 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+
+#include "TestTools.hpp"
+#include "Pipeline.hpp"
+
+// Streams fibonacci terms(mod 2^64) through the lock-free pipeline
+//
+// Usage: pipeline [Generators] [Consumers] [Blocks]
+
+#define ColumnWidth 14
+
+void PrintHeader()
+{
+	std::cout
+		<< std::setw(ColumnWidth) << "Stage"
+		<< std::setw(ColumnWidth) << "Blocks"
+		<< std::setw(ColumnWidth) << "MTerms/s"
+		<< std::setw(ColumnWidth) << "Stalls"
+		<< std::setw(ColumnWidth) << "Avg Depth"
+		<< std::setw(ColumnWidth) << "Max Depth" << '\n';
+}
+
+void PrintStage( const std::string& Name, const StageMetrics& Stage )
+{
+	std::cout
+		<< std::setw(ColumnWidth) << Name
+		<< std::setw(ColumnWidth) << Stage.Blocks
+		<< std::setw(ColumnWidth) << Stage.TermsPerSecond() / 1e6
+		<< std::setw(ColumnWidth) << Stage.Stalls
+		<< std::setw(ColumnWidth) << Stage.AverageDepth()
+		<< std::setw(ColumnWidth) << Stage.DepthMax << '\n';
+}
+
+// Blocks must come out contiguous and in order
+bool RunOrdered( std::size_t Generators, std::uint64_t Blocks )
+{
+	OrderedFibStream<> Stream(Generators);
+	StageMetrics Consumer;
+	bool Passed = true;
+	std::uint64_t Checksum = 0;
+	std::uint64_t Expected = 0;
+	// F(-2), F(-1) so that the first term checks out as F(0)
+	std::uint64_t Prev[2] = { static_cast<std::uint64_t>(-1), 1 };
+
+	Consumer.Start = std::chrono::high_resolution_clock::now();
+	for( std::uint64_t i = 0; i < Blocks; ++i )
+	{
+		const TermBlock* Block = Stream.Acquire(Consumer);
+		Passed &= Block->Index == Expected;
+		Passed &= Block->Terms[0] == Prev[0] + Prev[1];
+		for( std::size_t j = 0; j < BlockTerms; ++j )
+		{
+			Checksum ^= Block->Terms[j];
+		}
+		Prev[0] = Block->Terms[BlockTerms - 2];
+		Prev[1] = Block->Terms[BlockTerms - 1];
+		Expected += BlockTerms;
+		Stream.Release();
+	}
+	Consumer.Stop = std::chrono::high_resolution_clock::now();
+	Stream.Stop();
+
+	std::cout
+		<< "Ordered: " << Generators << " generator(s), 1 consumer "
+		<< (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m"
+		<< " checksum " << std::hex << Checksum << std::dec << '\n';
+	PrintHeader();
+	for( std::size_t i = 0; i < Generators; ++i )
+	{
+		PrintStage("Generator " + std::to_string(i), Stream.GeneratorMetrics()[i]);
+	}
+	PrintStage("Consumer", Consumer);
+	return Passed;
+}
+
+// Any consumer may pick up any block
+bool RunShared( std::size_t Consumers, std::uint64_t Blocks )
+{
+	SharedFibStream<> Stream;
+	std::vector<StageMetrics> Metrics(Consumers);
+	std::vector<std::thread> Threads;
+	std::atomic<std::int64_t> Remaining(static_cast<std::int64_t>(Blocks));
+	std::atomic<bool> Passed(true);
+
+	for( std::size_t i = 0; i < Consumers; ++i )
+	{
+		Threads.emplace_back(
+			[&, i]()
+			{
+				StageMetrics& Consumer = Metrics[i];
+				Consumer.Start = std::chrono::high_resolution_clock::now();
+				std::size_t Ticket;
+				while( Remaining.fetch_sub(1, std::memory_order_relaxed) > 0 )
+				{
+					const TermBlock* Block = Stream.Acquire(Ticket, Consumer);
+					if( Block == nullptr )
+					{
+						break;
+					}
+					// Spot-check the block against fast doubling
+					const auto Pair = FibPair<std::uint64_t>(Block->Index);
+					bool Valid = Block->Terms[0] == Pair.first && Block->Terms[1] == Pair.second;
+					std::uint64_t Sum = 0;
+					for( std::size_t j = 0; j < BlockTerms; ++j )
+					{
+						Sum += Block->Terms[j];
+					}
+					// sum F(i) over [n, n + k) = F(n + k + 1) - F(n + 1)
+					Valid &= Sum == FibPair<std::uint64_t>(Block->Index + BlockTerms + 1).first - Pair.second;
+					Stream.Release(Ticket);
+					if( !Valid )
+					{
+						Passed.store(false);
+					}
+				}
+				Consumer.Stop = std::chrono::high_resolution_clock::now();
+			}
+		);
+	}
+	for( auto& Thread : Threads )
+	{
+		Thread.join();
+	}
+	Stream.Stop();
+
+	std::cout
+		<< "Shared: 1 generator, " << Consumers << " consumer(s) "
+		<< (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m\n";
+	PrintHeader();
+	PrintStage("Generator", Stream.GeneratorMetrics());
+	for( std::size_t i = 0; i < Consumers; ++i )
+	{
+		PrintStage("Consumer " + std::to_string(i), Metrics[i]);
+	}
+	return Passed;
+}
+
+int main( int argc, char* argv[] )
+{
+	const std::size_t Generators = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2;
+	const std::size_t Consumers  = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 2;
+	const std::uint64_t Blocks   = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100000;
+
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	bool Passed = RunOrdered(std::max<std::size_t>(Generators, 1), Blocks);
+	std::cout << '\n';
+	Passed &= RunShared(std::max<std::size_t>(Consumers, 1), Blocks);
+
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
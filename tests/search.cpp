@@ -0,0 +1,163 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "TestTools.hpp"
+#include "FibSearch.hpp"
+
+// Lower bounds of random keys in sorted arrays from L2 to DRAM sized,
+// ns per key
+
+#define ColumnWidth 14
+
+// Halves the range without a branch, so the only stalls are the loads
+std::uint64_t BranchlessLowerBound( const std::uint64_t* Data, std::uint64_t Size, std::uint64_t Key )
+{
+	if( !Size )
+	{
+		return 0;
+	}
+	const std::uint64_t* Base = Data;
+	while( Size > 1 )
+	{
+		const std::uint64_t Half = Size / 2;
+		Base = Base[Half] < Key ? Base + Half : Base;
+		Size -= Half;
+	}
+	return static_cast<std::uint64_t>(Base - Data) + (*Base < Key);
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	bool Passed = true;
+
+	// The probe offsets are the exact head of FibMod64
+	for( std::size_t k = 0; k < FibSearchImpl::Terms; ++k )
+	{
+		Passed &= FibSearchImpl::Table()[k] == FibMod64[k];
+	}
+
+	// Every size around the windows and small orders, with duplicates, and
+	// every key in and around them
+	std::mt19937_64 Random(0);
+	for( std::uint64_t Size = 0; Size <= 200; ++Size )
+	{
+		std::vector<std::uint64_t> Data(Size);
+		for( std::uint64_t& Entry : Data )
+		{
+			Entry = Random() % (Size + 1) * 2 + 1;
+		}
+		std::sort(Data.begin(), Data.end());
+		std::vector<std::uint64_t> Keys;
+		for( std::uint64_t Key = 0; Key <= 2 * Size + 3; ++Key )
+		{
+			Keys.push_back(Key);
+		}
+		Keys.push_back(~std::uint64_t(0));
+		std::vector<std::uint64_t> Results(Keys.size());
+		FibSearchBatch(Data.data(), Size, Keys.data(), Results.data(), Keys.size());
+		for( std::size_t i = 0; i < Keys.size(); ++i )
+		{
+			const std::uint64_t Expected = std::lower_bound(Data.begin(), Data.end(), Keys[i]) - Data.begin();
+			Passed &= FibSearch(Data.data(), Size, Keys[i]) == Expected;
+			Passed &= BranchlessLowerBound(Data.data(), Size, Keys[i]) == Expected;
+			Passed &= Results[i] == Expected;
+		}
+	}
+	std::cout
+		<< "Small arrays " << (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m\n"
+		<< std::setw(ColumnWidth) << "Entries"
+		<< std::setw(ColumnWidth) << "MiB"
+		<< std::setw(ColumnWidth) << "lower_bound"
+		<< std::setw(ColumnWidth) << "Branchless"
+		<< std::setw(ColumnWidth) << "Fibonacci"
+		<< std::setw(ColumnWidth) << "Batch"
+		<< std::setw(ColumnWidth) << "Valid" << std::endl;
+
+	constexpr std::size_t Count = 1 << 16;
+	std::vector<std::uint64_t> Keys(Count), Expected(Count), Results(Count);
+	for( const std::size_t Log2 : { 15, 18, 21, 24, 27 } )
+	{
+		const std::uint64_t Size = std::uint64_t(1) << Log2;
+		std::vector<std::uint64_t> Data(Size);
+		for( std::uint64_t i = 0; i < Size; ++i )
+		{
+			Data[i] = i * 4 + (Random() & 3);
+		}
+		for( std::uint64_t& Key : Keys )
+		{
+			Key = Random() % (Size * 4 + 4);
+		}
+		for( std::size_t i = 0; i < Count; ++i )
+		{
+			Expected[i] = std::lower_bound(Data.begin(), Data.end(), Keys[i]) - Data.begin();
+		}
+
+		bool Valid = true;
+		const double LowerBound = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				for( std::size_t i = 0; i < Count; ++i )
+				{
+					Results[i] = std::lower_bound(Data.begin(), Data.end(), Keys[i]) - Data.begin();
+				}
+				return 0;
+			},
+			Count
+		);
+		const double Branchless = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				for( std::size_t i = 0; i < Count; ++i )
+				{
+					Results[i] = BranchlessLowerBound(Data.data(), Size, Keys[i]);
+				}
+				return 0;
+			},
+			Count
+		);
+		Valid &= Results == Expected;
+		const double Fibonacci = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				for( std::size_t i = 0; i < Count; ++i )
+				{
+					Results[i] = FibSearch(Data.data(), Size, Keys[i]);
+				}
+				return 0;
+			},
+			Count
+		);
+		Valid &= Results == Expected;
+		const double Batch = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibSearchBatch(Data.data(), Size, Keys.data(), Results.data(), Count);
+				return 0;
+			},
+			Count
+		);
+		Valid &= Results == Expected;
+
+		std::cout
+			<< std::setw(ColumnWidth) << Size
+			<< std::setw(ColumnWidth) << Size * sizeof(std::uint64_t) / (1024.0 * 1024.0)
+			<< std::setw(ColumnWidth) << LowerBound
+			<< std::setw(ColumnWidth) << Branchless
+			<< std::setw(ColumnWidth) << Fibonacci
+			<< std::setw(ColumnWidth) << Batch
+			<< std::setw(ColumnWidth - 1) << ' '
+			<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+		Passed &= Valid;
+	}
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
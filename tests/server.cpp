@@ -0,0 +1,43 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <atomic>
+#include <chrono>
+#include <string>
+
+#include <signal.h>
+
+#include "FibServer.hpp"
+
+// Serves F(n) mod 2^64 / mod m queries over a Unix-domain socket until
+// interrupted
+//
+// Usage: server [SocketPath] [MaxBatch] [DeadlineMicroseconds]
+
+static std::atomic<bool> Running(true);
+
+int main( int argc, char* argv[] )
+{
+	const std::string Path       = argc > 1 ? argv[1] : "/tmp/qfib.sock";
+	const std::size_t MaxBatch   = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 64;
+	const std::uint64_t Deadline = argc > 3 ? std::strtoull(argv[3], nullptr, 10) : 100;
+
+	signal(SIGINT, [](int){ Running.store(false); });
+	signal(SIGTERM, [](int){ Running.store(false); });
+	signal(SIGPIPE, SIG_IGN);
+
+	FibServer Server(Path, MaxBatch, std::chrono::microseconds(Deadline));
+	std::cout
+		<< "Listening on " << Path
+		<< " batch " << MaxBatch << " deadline " << Deadline << "us" << std::endl;
+	Server.Run(Running);
+
+	const FibServerStats& Stats = Server.Stats();
+	std::cout
+		<< Stats.Queries << " queries in " << Stats.Batches << " batches, "
+		<< Stats.Writes << " writes" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,130 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include "TestTools.hpp"
+#include "FibKernels.hpp"
+#include "FibBatch.hpp"
+#include "FibSorted.hpp"
+
+// Sorted batches of indices with random gaps, evaluated independently versus
+// incrementally, ns per index
+
+#define ColumnWidth 14
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	constexpr std::size_t Count = 1 << 16;
+	std::vector<std::uint64_t> Indices(Count);
+	std::vector<std::uint64_t> Expected(Count);
+	std::vector<std::uint64_t> Results(Count);
+	std::mt19937_64 Random(0);
+
+	// The bulk generator is the lower bound for the densest batches
+	std::cout
+		<< "Bulk generator: "
+		<< Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibGenerate64(0, Results.data(), Count);
+				return 0;
+			},
+			Count
+		)
+		<< "ns per term\n";
+
+	std::cout
+		<< std::setw(ColumnWidth) << "Max Gap"
+		<< std::setw(ColumnWidth) << "Chun-Min"
+		<< std::setw(ColumnWidth) << "Batch"
+		<< std::setw(ColumnWidth) << "Tile"
+		<< std::setw(ColumnWidth) << "Jump"
+		<< std::setw(ColumnWidth) << "Sorted" << std::endl;
+
+	bool Passed = true;
+	for( std::uint64_t MaxGap : { 1ULL, 4ULL, 16ULL, 64ULL, 256ULL, 4096ULL, 1ULL << 20, 1ULL << 40 } )
+	{
+		// Gaps are uniform within [0, MaxGap], so batches may repeat indices
+		std::uniform_int_distribution<std::uint64_t> Gap(0, MaxGap);
+		std::uint64_t n = 0;
+		for( std::size_t i = 0; i < Count; ++i )
+		{
+			n += Gap(Random);
+			Indices[i] = n;
+			Expected[i] = FibPair<std::uint64_t>(n).first;
+		}
+
+		// Each index on its own
+		const double ChunMin = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				for( std::size_t i = 0; i < Count; ++i )
+				{
+					Results[i] = FibPair<std::uint64_t>(Indices[i]).first;
+				}
+				return 0;
+			},
+			Count
+		);
+		Passed &= Results == Expected;
+		const double Batch = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibBatch64(Indices.data(), Results.data(), Count);
+				return 0;
+			},
+			Count
+		);
+		Passed &= Results == Expected;
+
+		// Incrementally, forcing either strategy and then choosing by gap
+		const double Tile = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibSortedBatch(Indices.data(), Results.data(), Count, ~0ULL);
+				return 0;
+			},
+			Count
+		);
+		Passed &= Results == Expected;
+		const double Jump = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibSortedBatch(Indices.data(), Results.data(), Count, 0);
+				return 0;
+			},
+			Count
+		);
+		Passed &= Results == Expected;
+		const double Sorted = Bench<>::BestPerItem(
+			[&]() -> int
+			{
+				FibSortedBatch(Indices.data(), Results.data(), Count);
+				return 0;
+			},
+			Count
+		);
+		Passed &= Results == Expected;
+
+		std::cout
+			<< std::setw(ColumnWidth) << MaxGap
+			<< std::setw(ColumnWidth) << ChunMin
+			<< std::setw(ColumnWidth) << Batch
+			<< std::setw(ColumnWidth) << Tile
+			<< std::setw(ColumnWidth) << Jump
+			<< std::setw(ColumnWidth) << Sorted << std::endl;
+	}
+
+	std::cout << (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,129 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#include <immintrin.h>
+
+#include "TestTools.hpp"
+#include "FibKernels.hpp"
+#include "FibStrided.hpp"
+
+// Every Stride-th term, ns per sample:
+// - Generating every term and keeping only the samples, as with fastgen
+// - Fast doubling of every sampled index on its own
+// - The strided generator
+
+#define ColumnWidth 14
+
+// Only worth running while the skipped terms fit in the time budget
+constexpr std::uint64_t MaxSkipStride = 1 << 14;
+
+void GenerateAndSkip( std::uint64_t Start, std::uint64_t Stride, std::uint64_t* Out, std::size_t Count )
+{
+	alignas(32) std::uint64_t Block[4];
+	__m256i FibState = FibState4x64(Start);
+	std::uint64_t Base = 0;
+	for( std::size_t i = 0; i < Count; ++i )
+	{
+		const std::uint64_t Offset = i * Stride;
+		while( Offset >= Base + 4 )
+		{
+			FibState = FibNext4x64(FibState);
+			Base += 4;
+		}
+		_mm256_store_si256(reinterpret_cast<__m256i*>(Block), FibState);
+		Out[i] = Block[Offset - Base];
+	}
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+
+	constexpr std::size_t Count = 4096;
+	constexpr std::uint64_t Start = 123456789;
+	std::vector<std::uint64_t> Expected(Count), Results(Count);
+
+	std::cout
+		<< Count << " samples from F(" << Start << ")\n"
+		<< std::setw(ColumnWidth) << "Stride"
+		<< std::setw(ColumnWidth) << "Skip"
+		<< std::setw(ColumnWidth) << "Doubling"
+		<< std::setw(ColumnWidth) << "Strided"
+		<< std::setw(ColumnWidth) << "Valid" << std::endl;
+
+	bool Passed = true;
+	for(
+		const std::uint64_t Stride : {
+			std::uint64_t(0), std::uint64_t(1), std::uint64_t(7), std::uint64_t(64),
+			std::uint64_t(1000), std::uint64_t(4096), std::uint64_t(1000000),
+			std::uint64_t(1) << 40, ~std::uint64_t(0) / Count
+		}
+	)
+	{
+		for( std::size_t i = 0; i < Count; ++i )
+		{
+			Expected[i] = FibPair<std::uint64_t>(Start + i * Stride).first;
+		}
+
+		// Including counts that leave a partial group
+		bool Valid = true;
+		for( const std::size_t Partial : { std::size_t(1), FibStridedGroup + 3, Count } )
+		{
+			std::fill(Results.begin(), Results.end(), 0);
+			FibStrided64(Start, Stride, Results.data(), Partial);
+			Valid &= std::equal(Results.begin(), Results.begin() + Partial, Expected.begin());
+			Valid &= std::all_of(Results.begin() + Partial, Results.end(), []( std::uint64_t x ){ return x == 0; });
+		}
+
+		std::cout << std::setw(ColumnWidth) << Stride;
+		if( Stride <= MaxSkipStride )
+		{
+			GenerateAndSkip(Start, Stride, Results.data(), Count);
+			Valid &= Results == Expected;
+			std::cout << std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> int
+				{
+					GenerateAndSkip(Start, Stride, Results.data(), Count);
+					return 0;
+				},
+				Count
+			);
+		}
+		else
+		{
+			std::cout << std::setw(ColumnWidth) << '-';
+		}
+		std::cout
+			<< std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> int
+				{
+					for( std::size_t i = 0; i < Count; ++i )
+					{
+						Results[i] = FibPair<std::uint64_t>(Start + i * Stride).first;
+					}
+					return 0;
+				},
+				Count
+			)
+			<< std::setw(ColumnWidth) << Bench<>::BestPerItem(
+				[&]() -> int
+				{
+					FibStrided64(Start, Stride, Results.data(), Count);
+					return 0;
+				},
+				Count
+			)
+			<< std::setw(ColumnWidth - 1) << ' '
+			<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+		Passed &= Valid;
+	}
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,306 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+
+#include "TestTools.hpp"
+#include "FibKernels.hpp"
+#include "FibVisit.hpp"
+
+// Reductions over the generated stream, generated into a buffer and then
+// scanned against fused into the generator per tile and per register,
+// ns per term
+
+#define ColumnWidth 14
+
+// Terms whose low bits are all zero, F(i) = 0 mod 2^k
+constexpr std::uint64_t ResidueMask  = (1ULL << 4) - 1;
+// The first i > 0 with F(i) = 0 mod 2^22 is 3 * 2^20, a fifth of the way
+// into the largest run
+constexpr std::uint64_t FindMask     = (1ULL << 22) - 1;
+
+// Runs start past F(0), which would match right away
+constexpr std::uint64_t First = 1;
+
+struct Results
+{
+	std::uint64_t Sum;
+	std::uint64_t Residues;
+	std::uint64_t Found;
+
+	bool operator==( const Results& Other ) const
+	{
+		return Sum == Other.Sum && Residues == Other.Residues && Found == Other.Found;
+	}
+};
+
+Results Scalar( std::uint64_t Start, std::uint64_t Count )
+{
+	auto Pair = FibPair<std::uint64_t>(Start);
+	Results Result = { 0, 0, Start + Count };
+	for( std::uint64_t i = 0; i < Count; ++i )
+	{
+		const std::uint64_t Term = Pair.first;
+		Result.Sum += Term;
+		Result.Residues += (Term & ResidueMask) == 0;
+		if( (Term & FindMask) == 0 && Result.Found == Start + Count )
+		{
+			Result.Found = Start + i;
+		}
+		Pair = { Pair.second, Pair.first + Pair.second };
+	}
+	return Result;
+}
+
+std::uint64_t SumTiles( std::uint64_t Start, std::uint64_t Count )
+{
+	std::uint64_t Sum = 0;
+	FibVisitTiles(
+		Start, Count,
+		[&]( const std::uint64_t* Terms, std::uint64_t, std::size_t Size ) -> bool
+		{
+			for( std::size_t i = 0; i < Size; ++i )
+			{
+				Sum += Terms[i];
+			}
+			return true;
+		}
+	);
+	return Sum;
+}
+
+std::uint64_t SumRegisters( std::uint64_t Start, std::uint64_t Count )
+{
+	__m256i Sum = _mm256_setzero_si256();
+	FibVisit(
+		Start, Count,
+		[&]( __m256i Terms, std::uint64_t, std::size_t Lanes ) -> bool
+		{
+			Sum = _mm256_add_epi64(Sum, FibVisitMasked(Terms, Lanes));
+			return true;
+		}
+	);
+	return FibVisitSum(Sum);
+}
+
+std::uint64_t ResiduesTiles( std::uint64_t Start, std::uint64_t Count )
+{
+	std::uint64_t Residues = 0;
+	FibVisitTiles(
+		Start, Count,
+		[&]( const std::uint64_t* Terms, std::uint64_t, std::size_t Size ) -> bool
+		{
+			for( std::size_t i = 0; i < Size; ++i )
+			{
+				Residues += (Terms[i] & ResidueMask) == 0;
+			}
+			return true;
+		}
+	);
+	return Residues;
+}
+
+std::uint64_t ResiduesRegisters( std::uint64_t Start, std::uint64_t Count )
+{
+	const __m256i Mask = _mm256_set1_epi64x(ResidueMask);
+	// Matches are all ones, so subtracting them counts up
+	__m256i Residues = _mm256_setzero_si256();
+	FibVisit(
+		Start, Count,
+		[&]( __m256i Terms, std::uint64_t, std::size_t Lanes ) -> bool
+		{
+			const __m256i Match = _mm256_cmpeq_epi64(_mm256_and_si256(Terms, Mask), _mm256_setzero_si256());
+			Residues = _mm256_sub_epi64(Residues, FibVisitMasked(Match, Lanes));
+			return true;
+		}
+	);
+	return FibVisitSum(Residues);
+}
+
+// Index of the first term in range with no bits of FindMask set, else the end
+std::uint64_t FindTiles( std::uint64_t Start, std::uint64_t Count )
+{
+	std::uint64_t Found = Start + Count;
+	FibVisitTiles(
+		Start, Count,
+		[&]( const std::uint64_t* Terms, std::uint64_t Index, std::size_t Size ) -> bool
+		{
+			const std::uint64_t* Match = std::find_if(
+				Terms, Terms + Size, []( std::uint64_t Term ) { return (Term & FindMask) == 0; }
+			);
+			if( Match == Terms + Size )
+			{
+				return true;
+			}
+			Found = Index + static_cast<std::uint64_t>(Match - Terms);
+			return false;
+		}
+	);
+	return Found;
+}
+
+std::uint64_t FindRegisters( std::uint64_t Start, std::uint64_t Count )
+{
+	const __m256i Mask = _mm256_set1_epi64x(FindMask);
+	std::uint64_t Found = Start + Count;
+	FibVisit(
+		Start, Count,
+		[&]( __m256i Terms, std::uint64_t Index, std::size_t Lanes ) -> bool
+		{
+			const __m256i Match = _mm256_cmpeq_epi64(_mm256_and_si256(Terms, Mask), _mm256_setzero_si256());
+			const int Bits = _mm256_movemask_pd(_mm256_castsi256_pd(Match)) & ((1 << Lanes) - 1);
+			if( !Bits )
+			{
+				return true;
+			}
+			Found = Index + static_cast<std::uint64_t>(__builtin_ctz(Bits));
+			return false;
+		}
+	);
+	return Found;
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+	std::cout << std::fixed << std::setprecision(2);
+	bool Passed = true;
+
+	// Every tail length around both the register and the tile sizes, from
+	// starts on and off a multiple of four
+	for( const std::uint64_t Start : { 0, 1, 3, 1000003 } )
+	{
+		for( std::uint64_t Count = 0; Count <= 2 * FibVisitTileTerms + 5; ++Count )
+		{
+			const Results Expected = Scalar(Start, Count);
+			const Results Tiles = { SumTiles(Start, Count), ResiduesTiles(Start, Count), FindTiles(Start, Count) };
+			const Results Registers = {
+				SumRegisters(Start, Count), ResiduesRegisters(Start, Count), FindRegisters(Start, Count)
+			};
+			Passed &= Tiles == Expected && Registers == Expected;
+		}
+	}
+
+	// Stopping hands back the index just past the block it stopped in
+	{
+		std::uint64_t Visited = 0;
+		const std::uint64_t End = FibVisitTiles(
+			7, 10000,
+			[&]( const std::uint64_t*, std::uint64_t, std::size_t Size ) -> bool
+			{
+				Visited += Size;
+				return Visited < 2 * FibVisitTileTerms;
+			}
+		);
+		Passed &= End == 7 + 2 * FibVisitTileTerms && Visited == 2 * FibVisitTileTerms;
+		const std::uint64_t RegisterEnd = FibVisit(
+			7, 10000, []( __m256i, std::uint64_t Index, std::size_t ) -> bool { return Index < 100; }
+		);
+		Passed &= RegisterEnd == 7 + 4 * 24 + 4;
+	}
+
+	std::cout
+		<< "Tails " << (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m\n"
+		<< std::setw(ColumnWidth) << "Terms"
+		<< std::setw(ColumnWidth) << "Workload"
+		<< std::setw(ColumnWidth) << "Buffered"
+		<< std::setw(ColumnWidth) << "Tiles"
+		<< std::setw(ColumnWidth) << "Registers"
+		<< std::setw(ColumnWidth) << "Valid" << std::endl;
+
+	for( const std::size_t Log2 : { 14, 18, 24 } )
+	{
+		const std::uint64_t Count = std::uint64_t(1) << Log2;
+		const Results Expected = Scalar(First, Count);
+		std::vector<std::uint64_t> Buffer(Count);
+		std::uint64_t Value = 0;
+
+		const auto Row = [&](
+			const char* Workload, std::uint64_t Want,
+			std::uint64_t (*Scan)( const std::vector<std::uint64_t>& ),
+			std::uint64_t (*Tiles)( std::uint64_t, std::uint64_t ),
+			std::uint64_t (*Registers)( std::uint64_t, std::uint64_t )
+		)
+		{
+			bool Valid = true;
+			const double Buffered = Bench<>::BestPerItem(
+				[&]() -> int
+				{
+					FibGenerate64(First, Buffer.data(), Count);
+					Value = Scan(Buffer);
+					return 0;
+				},
+				Count
+			);
+			Valid &= Value == Want;
+			const double Tiled = Bench<>::BestPerItem(
+				[&]() -> int
+				{
+					Value = Tiles(First, Count);
+					return 0;
+				},
+				Count
+			);
+			Valid &= Value == Want;
+			const double Registered = Bench<>::BestPerItem(
+				[&]() -> int
+				{
+					Value = Registers(First, Count);
+					return 0;
+				},
+				Count
+			);
+			Valid &= Value == Want;
+
+			std::cout
+				<< std::setw(ColumnWidth) << Count
+				<< std::setw(ColumnWidth) << Workload
+				<< std::setw(ColumnWidth) << Buffered
+				<< std::setw(ColumnWidth) << Tiled
+				<< std::setw(ColumnWidth) << Registered
+				<< std::setw(ColumnWidth - 1) << ' '
+				<< (Valid ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m" << std::endl;
+			Passed &= Valid;
+		};
+
+		Row(
+			"Checksum", Expected.Sum,
+			[]( const std::vector<std::uint64_t>& Terms ) -> std::uint64_t
+			{
+				std::uint64_t Sum = 0;
+				for( const std::uint64_t Term : Terms )
+				{
+					Sum += Term;
+				}
+				return Sum;
+			},
+			SumTiles, SumRegisters
+		);
+		Row(
+			"Residues", Expected.Residues,
+			[]( const std::vector<std::uint64_t>& Terms ) -> std::uint64_t
+			{
+				return static_cast<std::uint64_t>(std::count_if(
+					Terms.begin(), Terms.end(), []( std::uint64_t Term ) { return (Term & ResidueMask) == 0; }
+				));
+			},
+			ResiduesTiles, ResiduesRegisters
+		);
+		Row(
+			"Find", Expected.Found,
+			[]( const std::vector<std::uint64_t>& Terms ) -> std::uint64_t
+			{
+				return First + static_cast<std::uint64_t>(std::find_if(
+					Terms.begin(), Terms.end(), []( std::uint64_t Term ) { return (Term & FindMask) == 0; }
+				) - Terms.begin());
+			},
+			FindTiles, FindRegisters
+		);
+	}
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,153 @@
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <type_traits>
+
+#include "TestTools.hpp"
+#include "WideInt.hpp"
+#include "BigUInt.hpp"
+
+// Exact fibonacci terms past the mod 2^64 wrap-around of F(94), using fixed
+// width 128-bit and 256-bit integers, compared against the general bignum path
+
+template< std::size_t Words >
+std::uint64_t LowWord( const WideUInt<Words>& Value )
+{
+	return Value.Limb[0];
+}
+
+std::uint64_t LowWord( const BigUInt& Value )
+{
+	return Value.Limb.empty() ? 0 : Value.Limb[0];
+}
+
+#define ColumnWidth 18
+
+// Verify every exact term in range against the bignum path and against the
+// truncated FibMod64 table
+template< std::size_t Words >
+bool Verify()
+{
+	bool Passed = true;
+	WideFibGenerator<Words> Generator;
+	for( std::uint64_t n = 0; n <= WideFibMaxIndex(Words); ++n )
+	{
+		const BigUInt Exact = FibBig(n);
+		Passed &= Exact.Equals(FibWide<Words>(n));
+		Passed &= Exact.Equals(Generator.Get());
+		if( n < std::extent<decltype(FibMod64)>::value )
+		{
+			Passed &= LowWord(Generator.Get()) == FibMod64[n];
+		}
+		Generator.Advance();
+	}
+	// One past the exact range wraps around, but keeps the low bits
+	const std::uint64_t Past = WideFibMaxIndex(Words) + 1;
+	const BigUInt PastExact = FibBig(Past);
+	Passed &= !PastExact.Equals(FibWide<Words>(Past));
+	Passed &= BigUInt(PastExact.Limb.data(), Words).Equals(FibWide<Words>(Past));
+	std::cout
+		<< std::setw(4) << Words * 64 << "-bit: F(0) to F(" << WideFibMaxIndex(Words) << ") "
+		<< (Passed ? "\033[1;32m\u2714":"\033[1;31m\u2717") << "\033[0m\n";
+	return Passed;
+}
+
+int main()
+{
+	std::cout << GetProcessorBrandString() << std::endl;
+
+	const bool Passed = Verify<2>() & Verify<4>();
+
+	std::cout
+		<< "F(" << WideFibMaxIndex(2) << ") = " << FibWide<2>(WideFibMaxIndex(2)).ToString() << '\n'
+		<< "F(" << WideFibMaxIndex(4) << ") = " << FibWide<4>(WideFibMaxIndex(4)).ToString() << '\n';
+
+	// Fast doubling queries, ns per query
+	std::cout
+		<< "Fast doubling(ns)\nn\t|"
+		<< std::setw(ColumnWidth) << "128-bit"
+		<< std::setw(ColumnWidth) << "256-bit"
+		<< std::setw(ColumnWidth) << "Bignum" << std::endl;
+	for( std::uint64_t n = 94; n <= WideFibMaxIndex(4); n += 23 )
+	{
+		std::cout << n << "\t|";
+		if( n <= WideFibMaxIndex(2) )
+		{
+			const auto Result = Bench<>::BenchResult(FibWide<2>, n);
+			std::cout << std::setw(ColumnWidth - 1) << std::get<0>(Result).count() << '|';
+		}
+		else
+		{
+			std::cout << std::setw(ColumnWidth) << "---|";
+		}
+		const auto Result256 = Bench<>::BenchResult(FibWide<4>, n);
+		const auto ResultBig = Bench<>::BenchResult(FibBig, n);
+		std::cout
+			<< std::setw(ColumnWidth - 1) << std::get<0>(Result256).count() << '|'
+			<< std::setw(ColumnWidth - 1) << std::get<0>(ResultBig).count() << '|'
+			<< std::endl;
+	}
+
+	// Sequential generation of every exact term, ns per term
+	constexpr std::size_t Rounds = 1000;
+	std::vector<UInt128> Terms128(WideFibMaxIndex(2) + 1);
+	std::vector<UInt256> Terms256(WideFibMaxIndex(4) + 1);
+	std::vector<BigUInt> TermsBig(WideFibMaxIndex(4) + 1);
+	std::uint64_t Sink = 0;
+
+	const auto Time128 = std::get<0>(Bench<>::BenchResult(
+		[&]() -> std::uint64_t
+		{
+			for( std::size_t i = 0; i < Rounds; ++i )
+			{
+				WideFibGenerator<2>().Generate(Terms128.data(), Terms128.size());
+				Sink += LowWord(Terms128.back());
+			}
+			return Sink;
+		}
+	));
+	const auto Time256 = std::get<0>(Bench<>::BenchResult(
+		[&]() -> std::uint64_t
+		{
+			for( std::size_t i = 0; i < Rounds; ++i )
+			{
+				WideFibGenerator<4>().Generate(Terms256.data(), Terms256.size());
+				Sink += LowWord(Terms256.back());
+			}
+			return Sink;
+		}
+	));
+	const auto TimeBig = std::get<0>(Bench<>::BenchResult(
+		[&]() -> std::uint64_t
+		{
+			for( std::size_t i = 0; i < Rounds; ++i )
+			{
+				TermsBig[0] = BigUInt(0);
+				TermsBig[1] = BigUInt(1);
+				for( std::size_t n = 2; n < TermsBig.size(); ++n )
+				{
+					TermsBig[n] = TermsBig[n - 1] + TermsBig[n - 2];
+				}
+				Sink += LowWord(TermsBig.back());
+			}
+			return Sink;
+		}
+	));
+
+	std::cout << std::fixed << std::setprecision(2)
+		<< "Generation(ns/term)\n"
+		<< std::setw(ColumnWidth) << "128-bit"
+		<< std::setw(ColumnWidth) << "256-bit"
+		<< std::setw(ColumnWidth) << "Bignum" << '\n'
+		<< std::setw(ColumnWidth) << Time128.count() / double(Rounds * Terms128.size())
+		<< std::setw(ColumnWidth) << Time256.count() / double(Rounds * Terms256.size())
+		<< std::setw(ColumnWidth) << TimeBig.count() / double(Rounds * TermsBig.size())
+		<< std::endl;
+
+	return Passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}